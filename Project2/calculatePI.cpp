@@ -1,128 +1,244 @@
 #include<iostream>
 #include<vector>
+#include<string>
 #include<cstdlib>
-#include<cmath>
+#include<cstdint>
+#include<algorithm>
+#include<memory>
 #include<thread>
-#include<mutex>
 #include<unistd.h>
 
-const int TOTAL_POINTS = 1000000000;
-
-std::mutex mutex;
+const long long TOTAL_POINTS = 1000000000;
+const long long CHUNK_POINTS = 1 << 20;  // points generated from each jump of the random number generator
 
 struct Point {
+    Point() = default;  // left uninitialized; generatePoints fills in every point
     Point(double xx, double yy): x{xx}, y{yy} {}
 
     void print() { std::cout << "(" << x << ", " << y << ")\n"; }
     double x, y;
 };
 
-double nextRand() {
-    // return a value in the range (-1, 1)
+class Xoshiro256 {
+    // xoshiro256** (Blackman and Vigna): a fast generator with 256 bits of state whose jump() moves it 2^128 numbers
+    // ahead, so each chunk of points can have its own stream that never overlaps another chunk's.
+public:
+    explicit Xoshiro256(uint64_t seed) {
+        // Spreads the seed over the state with splitmix64, as the authors recommend.
+        for( int i = 0; i < 4; i++ ) {
+            seed += 0x9e3779b97f4a7c15;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            state[i] = z ^ (z >> 31);
+        }
+    }
 
-    return (rand() / double(RAND_MAX)) * 2 - 1;
-}
+    uint64_t next() {
+        uint64_t result = rotl(state[1] * 5, 7) * 9;
+        uint64_t t = state[1] << 17;
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
 
-void printPointsInQuadrant(const std::vector<Point> &points, int quadrant, int* totalQuadrantPoints) {
-    // Counts and prints the number of points in each quadrant.
-
-    std::cout << "Partitioning points for quadrant " << quadrant + 1 << std::endl;
-    int one = 0, two = 0, three = 0, four = 0; 
-    for( auto iter = points.begin(); iter != points.end(); iter++ ) {
-        switch(quadrant){
-            case 0:
-                if( iter->x > 0 && iter->y > 0 ){
-                    one++;
-                    mutex.lock();
-                    *totalQuadrantPoints += 1;
-                    mutex.unlock();
-                }
-                break;
-            case 1:
-                if( iter->x > 0 && iter->y < 0 ){
-                    two++;
-                    mutex.lock();
-                    *totalQuadrantPoints += 1;
-                    mutex.unlock();
-                }
-                break;
-            case 2:
-                if( iter->x < 0 && iter->y < 0 ){
-                    three++;
-                    mutex.lock();
-                    *totalQuadrantPoints += 1;
-                    mutex.unlock();
-                }
-                break;
-            case 3:
-                if( iter->x < 0 && iter->y > 0 ){
-                    four++;
-                    mutex.lock();
-                    *totalQuadrantPoints += 1;
-                    mutex.unlock();
-                }
-                break;
+    double nextCoordinate() {
+        // return a value in the range [-1, 1) from the top 53 bits
+        return (next() >> 11) * 0x1.0p-52 - 1.0;
+    }
+
+    void jump() {
+        static const uint64_t JUMP[] = { 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+        uint64_t jumped[4] = {0, 0, 0, 0};
+        for( uint64_t word : JUMP ) {
+            for( int bit = 0; bit < 64; bit++ ) {
+                if( word & (uint64_t(1) << bit) )
+                    for( int i = 0; i < 4; i++ )
+                        jumped[i] ^= state[i];
+                next();
+            }
         }
+        std::copy(jumped, jumped + 4, state);
     }
 
-    switch(quadrant){
-        case 0:
-            std::cout << "points in quadrant 1: " << one << std::endl;
-            break;
-        case 1:
-            std::cout << "points in quadrant 2: " << two << std::endl;
-            break;
-        case 2:
-            std::cout << "points in quadrant 3: " << three << std::endl;
-            break;
-        case 3:
-            std::cout << "points in quadrant 4: " << four << std::endl;
-            break;
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    uint64_t state[4];
+};
+
+template <class ChunkFunction>
+void forEachChunk(uint64_t seed, long long numPoints, int worker, int numWorkers, ChunkFunction chunkFunction) {
+    // Calls chunkFunction(generator, first, last) for chunks worker, worker + numWorkers, ... of the numPoints points.
+    // Chunk c always gets the generator seeded with seed and jumped c times, so every point is the same however many
+    // workers share the work.
+
+    Xoshiro256 generator(seed);
+    for( int i = 0; i < worker; i++ )
+        generator.jump();
+    for( long long first = worker * CHUNK_POINTS; first < numPoints; first += numWorkers * CHUNK_POINTS ) {
+        Xoshiro256 chunkGenerator = generator;
+        chunkFunction(chunkGenerator, first, std::min(first + CHUNK_POINTS, numPoints));
+        for( int i = 0; i < numWorkers; i++ )
+            generator.jump();
     }
 }
 
-int countInCircle(const std::vector<Point> &points) {
-    int inCircle = 0;
-    for( auto iter = points.begin(); iter != points.end(); iter++ )
-	if( sqrt( iter->x * iter->x + iter->y * iter->y ) <= 1.0 )  // is the point in the circle?
-	    inCircle++;
-    return inCircle;
+struct Counts {
+    long long quadrant[4] = {0, 0, 0, 0};
+    long long inCircle = 0;
+};
+
+inline void classify(double x, double y, Counts &counts) {
+    // Adds one point to its quadrant (points on an axis are in none) and to the circle count. Comparing x^2 + y^2 with
+    // 1 gives the same answer as comparing the distance, without the square root.
+
+    counts.quadrant[0] += x > 0 && y > 0;
+    counts.quadrant[1] += x > 0 && y < 0;
+    counts.quadrant[2] += x < 0 && y < 0;
+    counts.quadrant[3] += x < 0 && y > 0;
+    counts.inCircle += x * x + y * y <= 1.0;  // is the point in the circle?
 }
 
-void generatePoints(std::vector<Point> &points) {
-    // Generates TOTAL_POINTS points.
+struct PointSpan {
+    // A read-only view of part of the points. Threads are given spans rather than the array, so the points are shared
+    // and never copied.
+    const Point *first;
+    const Point *last;
+};
 
-    std::cout << "Will generate " << TOTAL_POINTS << std::endl;
-    for( int i = 0; i < TOTAL_POINTS; i++ ) { 
-	points.push_back(Point(nextRand(), nextRand()));
-    }
-    std::cout << "Finished generating points...\n";
+std::vector<PointSpan> partition(const Point *points, long long numPoints, int numParts) {
+    // Splits the numPoints points into numParts contiguous spans of nearly equal size.
+
+    std::vector<PointSpan> spans;
+    for( int i = 0; i < numParts; i++ )
+        spans.push_back({points + numPoints * i / numParts, points + numPoints * (i + 1) / numParts});
+    return spans;
 }
 
+template <class Work>
+void runThreads(int numThreads, const Work &work) {
+    // Runs work(t) on each of numThreads threads and waits for them to finish. The threads call work through a
+    // reference, so whatever it captures is shared with them rather than copied into each one.
 
-int main() {
-    srand(getpid());
-    std::vector<Point> points;
-    std::thread threads[4];
-    int totalPoints = 0;
+    std::vector<std::thread> threads;
+    for( int t = 0; t < numThreads; t++ )
+        threads.push_back(std::thread(std::cref(work), t));
+    for( auto &thread : threads )
+        thread.join();
+}
 
-    std::cout << "It takes some time for this program to print its result.\n";
+void classifyPoints(PointSpan span, Counts &counts) {
+    // Counts the quadrants and the circle for the points in span in a single pass.
+
+    Counts local;
+    for( const Point *point = span.first; point != span.last; point++ )
+        classify(point->x, point->y, local);
+    counts = local;
+}
 
-    generatePoints(points);
+void addCounts(const std::vector<Counts> &threadCounts, Counts &counts) {
+    // Merges the counts that each thread kept on its own.
 
-    for(int i = 0; i < 4; i++){
-        threads[i] = std::thread(printPointsInQuadrant, points, i, &totalPoints);
-    }    
+    for( const Counts &local : threadCounts ) {
+        for( int i = 0; i < 4; i++ )
+            counts.quadrant[i] += local.quadrant[i];
+        counts.inCircle += local.inCircle;
+    }
+}
 
-    for(int i = 0; i < 4; i++){
-        threads[i].join();
+void printCounts(const Counts &counts, long long numPoints) {
+    long long totalPoints = 0;
+    for( int i = 0; i < 4; i++ ) {
+        std::cout << "points in quadrant " << i + 1 << ": " << counts.quadrant[i] << std::endl;
+        totalPoints += counts.quadrant[i];
     }
+    std::cout << "Total Points: " << totalPoints << std::endl;
+    std::cout << "PI = " << double(counts.inCircle) * double(4.0) / double(numPoints) << std::endl;
+}
+
+std::unique_ptr<Point[]> generatePoints(long long numPoints, uint64_t seed, int numThreads) {
+    // Generates numPoints points, split across numThreads threads. The array is not initialized first, so each page is
+    // first touched by the thread that fills it rather than all of them by the main thread.
+
+    std::cout << "Will generate " << numPoints << std::endl;
+    std::unique_ptr<Point[]> points(new Point[numPoints]);
+    Point *data = points.get();
+    runThreads(numThreads, [=](int t) {
+        forEachChunk(seed, numPoints, t, numThreads, [=](Xoshiro256 &generator, long long first, long long last) {
+            for( long long i = first; i < last; i++ ) {
+                double x = generator.nextCoordinate();
+                data[i] = Point(x, generator.nextCoordinate());
+            }
+        });
+    });
+    std::cout << "Finished generating points...\n";
+    return points;
+}
+
+void streamPoints(long long numPoints, uint64_t seed, int numThreads, Counts &counts) {
+    // Generates numPoints points across numThreads threads and classifies each one as soon as it is made, so the
+    // points are never stored and memory use does not grow with numPoints.
+
+    std::cout << "Will generate and count " << numPoints << std::endl;
+    std::vector<Counts> threadCounts(numThreads);
+    runThreads(numThreads, [&](int t) {
+        Counts local;
+        forEachChunk(seed, numPoints, t, numThreads, [&](Xoshiro256 &generator, long long first, long long last) {
+            for( long long i = first; i < last; i++ ) {
+                double x = generator.nextCoordinate();
+                classify(x, generator.nextCoordinate(), local);
+            }
+        });
+        threadCounts[t] = local;
+    });
+    addCounts(threadCounts, counts);
+    std::cout << "Finished counting points...\n";
+}
+
+int main(int argc, char *argv[]) {
+    // Usage: a.out [--materialize] [--threads n] [--seed s] [number of points]
+    // By default the points are counted as they are generated. --materialize stores all of them first, which needs
+    // 16 bytes per point. The same seed gives the same points, and so the same counts, for any number of threads.
+    bool materialize = false;
+    long long numPoints = TOTAL_POINTS;
+    int numThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = getpid();
+    for( int i = 1; i < argc; i++ ) {
+        std::string arg = argv[i];
+        if( arg == "--materialize" )
+            materialize = true;
+        else if( arg == "--threads" && i + 1 < argc )
+            numThreads = std::max(1, std::atoi(argv[++i]));
+        else if( arg == "--seed" && i + 1 < argc )
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        else
+            numPoints = std::atoll(argv[i]);
+    }
+    std::cout << "Seed: " << seed << ", threads: " << numThreads << std::endl;
+
+    Counts counts;
+    if( ! materialize ) {
+        streamPoints(numPoints, seed, numThreads, counts);
+        printCounts(counts, numPoints);
+        return 0;
+    }
+
+    std::cout << "It takes some time for this program to print its result.\n";
 
-    int inCircle = countInCircle(points);
+    std::unique_ptr<Point[]> points = generatePoints(numPoints, seed, numThreads);
 
-    std:: cout << "Total Points: " << totalPoints << std::endl;
+    // Each thread counts one contiguous partition of the points, so the points are read once in all.
+    std::vector<PointSpan> spans = partition(points.get(), numPoints, numThreads);
+    std::vector<Counts> threadCounts(numThreads);
+    runThreads(numThreads, [&](int t) { classifyPoints(spans[t], threadCounts[t]); });
+    addCounts(threadCounts, counts);
 
-    std::cout << "PI = " << double(inCircle) * double(4.0) / double(TOTAL_POINTS) << std::endl;
+    printCounts(counts, numPoints);
 
     return 0;
 }
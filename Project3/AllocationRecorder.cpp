@@ -0,0 +1,151 @@
+#include "AllocationRecorder.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+
+/********************************************************************************
+*   Function:   AllocationRecorder                                              *
+*   Parameters: const char *path                                                *
+*   Return Value: None                                                          *
+*   Description: creates the trace file at path and writes its header. If the   *
+*                file cannot be created, isOpen returns false and nothing is    *
+*                recorded.                                                      *
+********************************************************************************/
+AllocationRecorder::AllocationRecorder(const char *path)
+{
+    numBuffered = 0;
+    nextId = 0;
+    lastTime = std::chrono::steady_clock::now();
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    if(fd >= 0 && write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+    {
+        close(fd);
+        fd = -1;
+    }
+}
+
+/********************************************************************************
+*   Function:   ~AllocationRecorder                                             *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: writes out the buffered records and closes the trace file.     *
+********************************************************************************/
+AllocationRecorder::~AllocationRecorder()
+{
+    flush();
+    if(fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+/********************************************************************************
+*   Function:   isOpen                                                          *
+*   Parameters: None                                                            *
+*   Return Value: bool                                                          *
+*   Description: returns true if the trace file is being written.               *
+********************************************************************************/
+bool AllocationRecorder::isOpen()
+{
+    return fd >= 0;
+}
+
+/********************************************************************************
+*   Function:   allocated                                                       *
+*   Parameters: void *ptrToMem, size_t numBytes                                 *
+*   Return Value: None                                                          *
+*   Description: gives the block at ptrToMem the most recently freed id, or a   *
+*                new one if none is free, and records its allocation. Failed    *
+*                allocations are not recorded, since the replay could not free  *
+*                them.                                                          *
+********************************************************************************/
+void AllocationRecorder::allocated(void *ptrToMem, size_t numBytes)
+{
+    if(ptrToMem == nullptr)
+    {
+        return;
+    }
+
+    uint32_t id;
+    if(freeIds.empty())
+    {
+        id = nextId++;
+    }
+    else
+    {
+        id = freeIds.back();
+        freeIds.pop_back();
+    }
+    ids[ptrToMem] = id;
+    append(ALLOCATE, id, numBytes);
+}
+
+/********************************************************************************
+*   Function:   freed                                                           *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: None                                                          *
+*   Description: records the free of the block at ptrToMem and makes its id     *
+*                available again. Blocks that were allocated before recording   *
+*                started are ignored.                                           *
+********************************************************************************/
+void AllocationRecorder::freed(void *ptrToMem)
+{
+    auto found = ids.find(ptrToMem);
+    if(found == ids.end())
+    {
+        return;
+    }
+
+    append(FREE, found->second, 0);
+    freeIds.push_back(found->second);
+    ids.erase(found);
+}
+
+/********************************************************************************
+*   Function:   flush                                                           *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: writes the buffered records to the trace file.                 *
+********************************************************************************/
+void AllocationRecorder::flush()
+{
+    if(fd >= 0 && numBuffered > 0)
+    {
+        ssize_t numBytes = numBuffered * sizeof(Record);
+        if(write(fd, buffer, numBytes) != numBytes)
+        {
+            close(fd);
+            fd = -1;
+        }
+    }
+    numBuffered = 0;
+}
+
+/********************************************************************************
+*   Function:   append                                                          *
+*   Parameters: Operation operation, uint32_t id, size_t numBytes               *
+*   Return Value: None                                                          *
+*   Description: adds a record to the buffer, writing the buffer out when it is *
+*                full. The time is stored relative to the previous record, so   *
+*                that it fits in 32 bits. The size is stored whole.             *
+********************************************************************************/
+void AllocationRecorder::append(Operation operation, uint32_t id, size_t numBytes)
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastTime).count();
+    lastTime = now;
+
+    Record &record = buffer[numBuffered++];
+    record.size = numBytes;
+    record.time = elapsed > UINT32_MAX ? UINT32_MAX : (uint32_t)elapsed;
+    record.id = id;
+    record.operation = operation;
+    record.unused = 0;
+    if(numBuffered == BUFFER_RECORDS)
+    {
+        flush();
+    }
+}
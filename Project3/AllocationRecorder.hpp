@@ -0,0 +1,75 @@
+#ifndef _AllocationRecorder_hpp
+#define _AllocationRecorder_hpp
+#include <stddef.h>
+#include <stdint.h>
+#include <chrono>
+#include <unordered_map>
+#include <vector>
+
+// Records the allocations and frees a program makes to a compact binary trace file, so that the same sequence can be
+// replayed later against any allocator (benchmark.x --replay does this). Each block takes the id of the block freed
+// most recently, and a new id only when no freed id is waiting, so ids stay below the largest number of blocks ever
+// live at once and the replay can keep them in an array.
+// Either call allocated and freed next to the program's own calls, or wrap its heap in a RecordingHeap. Not thread
+// safe: give each thread its own recorder.
+class AllocationRecorder {
+    enum { BUFFER_RECORDS = 4096 };
+public:
+    enum Operation { ALLOCATE = 1, FREE = 2 };
+    // A trace file is this header followed by one Record per operation until the end of the file.
+    struct FileHeader {
+        char magic[8];
+    };
+    // Version 2 widened size from 32 bits, which saturated blocks of 4 GiB or more, to 64.
+    struct Record {
+        uint64_t size;      // bytes requested; 0 for FREE.
+        uint32_t time;      // nanoseconds since the previous record, saturating at UINT32_MAX.
+        uint32_t id;
+        uint32_t operation;
+        uint32_t unused;    // keeps the next record's size 8-byte aligned.
+    };
+    static constexpr char MAGIC[8] = {'A', 'L', 'L', 'O', 'C', 'T', 'R', '2'};
+
+    AllocationRecorder(const char *path);
+    ~AllocationRecorder();
+    bool isOpen();
+    void allocated(void *ptrToMem, size_t numBytes); // record that "ptrToMem" was returned for "numBytes" bytes.
+    void freed(void *ptrToMem);                      // record that "ptrToMem" is being freed.
+    void flush();
+
+private:
+    int fd;
+    Record buffer[BUFFER_RECORDS];
+    int numBuffered;
+    std::chrono::steady_clock::time_point lastTime;
+    std::unordered_map<void*, uint32_t> ids;
+    std::vector<uint32_t> freeIds;  // ids of freed blocks, reused last freed first before new ones are handed out.
+    uint32_t nextId;
+
+    void append(Operation operation, uint32_t id, size_t numBytes);
+};
+
+// Any heap with allocate and free, with every call recorded.
+template <class Heap>
+class RecordingHeap {
+public:
+    RecordingHeap(Heap *heap, const char *path): heap(heap), recorder(path) {}
+    void* allocate(size_t numBytes)
+    {
+        void *ptrToMem = heap->allocate(numBytes);
+        recorder.allocated(ptrToMem, numBytes);
+        return ptrToMem;
+    }
+    void free(void *ptrToMem)
+    {
+        recorder.freed(ptrToMem);
+        heap->free(ptrToMem);
+    }
+    AllocationRecorder* trace() { return &recorder; }
+
+private:
+    Heap *heap;
+    AllocationRecorder recorder;
+};
+
+#endif
@@ -0,0 +1,554 @@
+#include "ArenaHeap.hpp"
+#include <new>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/********************************************************************************
+*   Function:   roundToPages                                                    *
+*   Parameters: size_t numBytes                                                 *
+*   Return Value: size_t                                                        *
+*   Description: rounds numBytes up to a whole number of pages.                 *
+********************************************************************************/
+static size_t roundToPages(size_t numBytes)
+{
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    return (numBytes + pageSize - 1) & ~(pageSize - 1);
+}
+
+/********************************************************************************
+*   Function:   ArenaHeap                                                       *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: starts with no arenas mapped. The first arena is mapped by the *
+*                first call to allocate.                                        *
+********************************************************************************/
+ArenaHeap::ArenaHeap()
+{
+    arenas = nullptr;
+    spare = nullptr;
+    largeChunks = nullptr;
+    arenaCount = 0;
+    totalMapped = 0;
+}
+
+/********************************************************************************
+*   Function:   ~ArenaHeap                                                      *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: returns every arena and large chunk to the OS.                 *
+********************************************************************************/
+ArenaHeap::~ArenaHeap()
+{
+    while(arenas != nullptr)
+    {
+        unmapArena(arenas);
+    }
+    while(largeChunks != nullptr)
+    {
+        LargeChunk *chunk = largeChunks;
+        largeChunks = chunk->next;
+        munmap(chunk, chunk->mappedBytes);
+    }
+}
+
+/********************************************************************************
+*   Function:   allocate                                                        *
+*   Parameters: size_t numBytes                                                 *
+*   Return Value: void*                                                         *
+*   Description: allocates numBytes bytes. Large requests get a mapping of      *
+*                their own. Otherwise the most recently used arenas are tried   *
+*                in order, and if none of the first MAX_ARENA_PROBES can hold   *
+*                the request the block comes from emptyArena. Arenas that are   *
+*                full sink to the back of the list, so the cost of a miss is    *
+*                bounded.                                                       *
+********************************************************************************/
+void* ArenaHeap::allocate(size_t numBytes)
+{
+    if(numBytes > LARGE_THRESHOLD)
+    {
+        return allocateLarge(numBytes, 16);
+    }
+    //BoundaryTag refuses blocks smaller than a free space, so round tiny requests up to the smallest it accepts.
+    if(numBytes < 2 * sizeof(BoundaryTag::Word))
+    {
+        numBytes = 2 * sizeof(BoundaryTag::Word);
+    }
+
+    int probes = 0;
+    for(Arena *arena = arenas; arena != nullptr && probes < MAX_ARENA_PROBES; arena = arena->next, probes++)
+    {
+        void *ptrToMemBlock = arena->tags.allocate(numBytes);
+        if(ptrToMemBlock != nullptr)
+        {
+            moveToFront(arena);
+            return ptrToMemBlock;
+        }
+    }
+
+    Arena *arena = emptyArena();
+    if(arena == nullptr)
+    {
+        return nullptr;
+    }
+    return arena->tags.allocate(numBytes);
+}
+
+/********************************************************************************
+*   Function:   allocate_aligned                                                *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: allocates numBytes bytes at a multiple of alignment, which     *
+*                must be a power of two. Arenas are tried as in allocate.       *
+*                Alignments too large for an arena to place well get a large    *
+*                chunk whose header is padded to the alignment.                 *
+********************************************************************************/
+void* ArenaHeap::allocate_aligned(size_t numBytes, size_t alignment)
+{
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return nullptr;
+    }
+    if(alignment <= sizeof(BoundaryTag::Word))
+    {
+        return allocate(numBytes);
+    }
+    if(numBytes > LARGE_THRESHOLD || alignment > LARGE_THRESHOLD)
+    {
+        return allocateLarge(numBytes, alignment);
+    }
+    if(numBytes < 2 * sizeof(BoundaryTag::Word))
+    {
+        numBytes = 2 * sizeof(BoundaryTag::Word);
+    }
+
+    int probes = 0;
+    for(Arena *arena = arenas; arena != nullptr && probes < MAX_ARENA_PROBES; arena = arena->next, probes++)
+    {
+        void *ptrToMemBlock = arena->tags.allocate_aligned(numBytes, alignment);
+        if(ptrToMemBlock != nullptr)
+        {
+            moveToFront(arena);
+            return ptrToMemBlock;
+        }
+    }
+
+    Arena *arena = emptyArena();
+    if(arena == nullptr)
+    {
+        return nullptr;
+    }
+    return arena->tags.allocate_aligned(numBytes, alignment);
+}
+
+/********************************************************************************
+*   Function:   free                                                            *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: None                                                          *
+*   Description: finds the mapping that ptrToMem belongs to with mappingOf.     *
+*                Large chunks are unmapped straight away.                       *
+*                Otherwise the block is freed in its arena, which moves to the  *
+*                front of the list as it now has space. An arena that becomes   *
+*                empty is unmapped, unless there is no empty spare arena yet,   *
+*                in which case it becomes the spare and only its pages are      *
+*                returned to the OS.                                            *
+********************************************************************************/
+void ArenaHeap::free(void *ptrToMem)
+{
+    if(ptrToMem == nullptr)
+    {
+        return;
+    }
+
+    void *base = mappingOf(ptrToMem);
+    if(*(int*)base == LARGE_CHUNK)
+    {
+        LargeChunk *chunk = (LargeChunk*)base;
+        if(chunk->prev != nullptr)
+        {
+            chunk->prev->next = chunk->next;
+        }
+        else
+        {
+            largeChunks = chunk->next;
+        }
+        if(chunk->next != nullptr)
+        {
+            chunk->next->prev = chunk->prev;
+        }
+        totalMapped -= chunk->mappedBytes;
+        munmap(chunk, chunk->mappedBytes);
+        return;
+    }
+
+    Arena *arena = (Arena*)base;
+    arena->tags.free(ptrToMem);
+    moveToFront(arena);
+
+    if(arena->tags.isEmpty())
+    {
+        if(spare != nullptr && spare != arena && spare->tags.isEmpty())
+        {
+            unmapArena(arena);
+        }
+        else
+        {
+            spare = arena;
+            arena->tags.trim();
+        }
+    }
+}
+
+/********************************************************************************
+*   Function:   reallocate                                                      *
+*   Parameters: void *ptrToMem, size_t numBytes, size_t alignment               *
+*   Return Value: void*                                                         *
+*   Description: resizes the block ptrToMem points to so it holds numBytes      *
+*                bytes and returns where it now is. A small block is resized by *
+*                its arena, which shrinks it or grows it into the free space to *
+*                its right without copying when it can. A large chunk is        *
+*                resized by its mapping. Only when neither works is a new block *
+*                allocated at a multiple of alignment and the contents copied.  *
+*                A null ptrToMem is an allocate and a numBytes of 0 is a free.  *
+*                If there is no room, nullptr is returned and the old block is  *
+*                left as it was.                                                *
+********************************************************************************/
+void* ArenaHeap::reallocate(void *ptrToMem, size_t numBytes, size_t alignment)
+{
+    if(ptrToMem == nullptr)
+    {
+        return allocate_aligned(numBytes, alignment);
+    }
+    if(numBytes == 0)
+    {
+        free(ptrToMem);
+        return nullptr;
+    }
+
+    void *base = mappingOf(ptrToMem);
+    if(*(int*)base == LARGE_CHUNK)
+    {
+        return reallocateLarge((LargeChunk*)base, ptrToMem, numBytes, alignment);
+    }
+
+    if(numBytes <= LARGE_THRESHOLD)
+    {
+        size_t arenaBytes = numBytes < 2 * sizeof(BoundaryTag::Word) ? 2 * sizeof(BoundaryTag::Word) : numBytes;
+        if(((Arena*)base)->tags.resizeInPlace(ptrToMem, arenaBytes))
+        {
+            return ptrToMem;
+        }
+    }
+
+    size_t oldBytes = usableSize(ptrToMem);
+    void *newPtr = allocate_aligned(numBytes, alignment);
+    if(newPtr != nullptr)
+    {
+        memcpy(newPtr, ptrToMem, numBytes < oldBytes ? numBytes : oldBytes);
+        free(ptrToMem);
+    }
+    return newPtr;
+}
+
+/********************************************************************************
+*   Function:   usableSize                                                      *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: size_t                                                        *
+*   Description: returns how many bytes the allocated block at ptrToMem holds,  *
+*                which may be more than were asked for. Only the header of the  *
+*                block is read, and it does not change while the block is       *
+*                allocated, so this does not need to be synchronized with other *
+*                calls on the heap.                                             *
+********************************************************************************/
+size_t ArenaHeap::usableSize(void *ptrToMem)
+{
+    void *base = mappingOf(ptrToMem);
+    if(*(int*)base == LARGE_CHUNK)
+    {
+        LargeChunk *chunk = (LargeChunk*)base;
+        return chunk->mappedBytes - ((char*)ptrToMem - (char*)chunk);
+    }
+
+    return ((Arena*)base)->tags.usableSize(ptrToMem);
+}
+
+/********************************************************************************
+*   Function:   numArenas                                                       *
+*   Parameters: None                                                            *
+*   Return Value: int                                                           *
+*   Description: returns the number of arenas currently mapped.                 *
+********************************************************************************/
+int ArenaHeap::numArenas()
+{
+    return arenaCount;
+}
+
+/********************************************************************************
+*   Function:   mappedBytes                                                     *
+*   Parameters: None                                                            *
+*   Return Value: size_t                                                        *
+*   Description: returns the number of bytes mapped for arenas and large        *
+*                chunks.                                                        *
+********************************************************************************/
+size_t ArenaHeap::mappedBytes()
+{
+    return totalMapped;
+}
+
+/********************************************************************************
+*   Function:   emptyArena                                                      *
+*   Parameters: None                                                            *
+*   Return Value: Arena*                                                        *
+*   Description: returns an empty arena at the front of the arena list for a    *
+*                request the probed arenas could not hold. The spare is used if *
+*                it is still empty: it was probed only if it was among the      *
+*                first MAX_ARENA_PROBES, and other arenas moving to the front   *
+*                push it past them. A new arena is mapped only when there is no *
+*                empty spare. Returns nullptr if the OS has no memory left.     *
+********************************************************************************/
+ArenaHeap::Arena* ArenaHeap::emptyArena()
+{
+    if(spare != nullptr && spare->tags.isEmpty())
+    {
+        moveToFront(spare);
+        return spare;
+    }
+    return mapArena();
+}
+
+/********************************************************************************
+*   Function:   mapArena                                                        *
+*   Parameters: None                                                            *
+*   Return Value: Arena*                                                        *
+*   Description: maps a new arena, constructs its boundary tags in place and    *
+*                puts it at the front of the arena list. Returns nullptr if the *
+*                OS has no memory left.                                         *
+********************************************************************************/
+ArenaHeap::Arena* ArenaHeap::mapArena()
+{
+    static_assert(sizeof(Arena) <= ARENA_ALIGNMENT, "free finds an arena by rounding down to ARENA_ALIGNMENT");
+
+    Arena *arena = (Arena*)mapAligned(sizeof(Arena), ARENA_ALIGNMENT, 0);
+    if(arena == nullptr)
+    {
+        return nullptr;
+    }
+
+    arena->kind = ARENA;
+    arena->prev = nullptr;
+    arena->next = arenas;
+    new (&arena->tags) BoundaryTag();
+    if(arenas != nullptr)
+    {
+        arenas->prev = arena;
+    }
+    arenas = arena;
+
+    arenaCount++;
+    totalMapped += roundToPages(sizeof(Arena));
+    return arena;
+}
+
+/********************************************************************************
+*   Function:   unmapArena                                                      *
+*   Parameters: Arena *arena                                                    *
+*   Return Value: None                                                          *
+*   Description: unlinks arena from the arena list and returns it to the OS.    *
+********************************************************************************/
+void ArenaHeap::unmapArena(Arena *arena)
+{
+    if(arena->prev != nullptr)
+    {
+        arena->prev->next = arena->next;
+    }
+    else
+    {
+        arenas = arena->next;
+    }
+    if(arena->next != nullptr)
+    {
+        arena->next->prev = arena->prev;
+    }
+    if(spare == arena)
+    {
+        spare = nullptr;
+    }
+
+    arena->tags.~BoundaryTag();
+    munmap(arena, roundToPages(sizeof(Arena)));
+    arenaCount--;
+    totalMapped -= roundToPages(sizeof(Arena));
+}
+
+/********************************************************************************
+*   Function:   moveToFront                                                     *
+*   Parameters: Arena *arena                                                    *
+*   Return Value: None                                                          *
+*   Description: moves arena to the front of the arena list so it is the first  *
+*                one allocate tries.                                            *
+********************************************************************************/
+void ArenaHeap::moveToFront(Arena *arena)
+{
+    if(arena == arenas)
+    {
+        return;
+    }
+
+    arena->prev->next = arena->next;
+    if(arena->next != nullptr)
+    {
+        arena->next->prev = arena->prev;
+    }
+    arena->prev = nullptr;
+    arena->next = arenas;
+    arenas->prev = arena;
+    arenas = arena;
+}
+
+/********************************************************************************
+*   Function:   allocateLarge                                                   *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: maps a chunk just for this request. The chunk starts with a    *
+*                LargeChunk header, padded to a multiple of alignment (at least *
+*                16 bytes, as malloc does). Chunks are mapped at a multiple of  *
+*                ARENA_ALIGNMENT, so the returned block is aligned as well. For *
+*                alignments of ARENA_ALIGNMENT or more the header is padded to  *
+*                ARENA_ALIGNMENT, and the chunk is placed that far below a      *
+*                multiple of alignment, so the header is still the first thing  *
+*                free finds below the block.                                    *
+********************************************************************************/
+void* ArenaHeap::allocateLarge(size_t numBytes, size_t alignment)
+{
+    if(alignment < 16)
+    {
+        alignment = 16;
+    }
+    size_t headerBytes = ARENA_ALIGNMENT;
+    size_t chunkAlignment = alignment;
+    if(alignment < ARENA_ALIGNMENT)
+    {
+        headerBytes = (sizeof(LargeChunk) + alignment - 1) & ~(alignment - 1);
+        chunkAlignment = ARENA_ALIGNMENT;
+    }
+    if(chunkAlignment > SIZE_MAX / 4 || numBytes > SIZE_MAX / 4 - chunkAlignment)
+    {
+        return nullptr;
+    }
+
+    size_t mappedBytes = roundToPages(headerBytes + numBytes);
+    size_t offset = alignment < ARENA_ALIGNMENT ? 0 : headerBytes;
+    LargeChunk *chunk = (LargeChunk*)mapAligned(mappedBytes, chunkAlignment, offset);
+    if(chunk == nullptr)
+    {
+        return nullptr;
+    }
+
+    chunk->kind = LARGE_CHUNK;
+    chunk->mappedBytes = mappedBytes;
+    chunk->prev = nullptr;
+    chunk->next = largeChunks;
+    if(largeChunks != nullptr)
+    {
+        largeChunks->prev = chunk;
+    }
+    largeChunks = chunk;
+
+    totalMapped += mappedBytes;
+    return (char*)chunk + headerBytes;
+}
+
+/********************************************************************************
+*   Function:   reallocateLarge                                                 *
+*   Parameters: LargeChunk *chunk, void *ptrToMem, size_t numBytes,             *
+*               size_t alignment                                                *
+*   Return Value: void*                                                         *
+*   Description: resizes the large chunk that holds ptrToMem. Shrinking unmaps  *
+*                the pages past the new end. Growing asks mremap to extend the  *
+*                mapping where it is; the chunk cannot be moved by mremap, as   *
+*                the new address would not be a multiple of ARENA_ALIGNMENT. If *
+*                the pages after the chunk are taken, a new block is allocated  *
+*                at a multiple of alignment and the contents copied.            *
+********************************************************************************/
+void* ArenaHeap::reallocateLarge(LargeChunk *chunk, void *ptrToMem, size_t numBytes, size_t alignment)
+{
+    size_t headerBytes = (char*)ptrToMem - (char*)chunk;
+    if(numBytes > SIZE_MAX / 4)
+    {
+        return nullptr;
+    }
+    size_t mappedBytes = roundToPages(headerBytes + numBytes);
+
+    if(mappedBytes <= chunk->mappedBytes)
+    {
+        if(mappedBytes < chunk->mappedBytes)
+        {
+            munmap((char*)chunk + mappedBytes, chunk->mappedBytes - mappedBytes);
+            totalMapped -= chunk->mappedBytes - mappedBytes;
+            chunk->mappedBytes = mappedBytes;
+        }
+        return ptrToMem;
+    }
+
+    if(mremap(chunk, chunk->mappedBytes, mappedBytes, 0) != MAP_FAILED)
+    {
+        totalMapped += mappedBytes - chunk->mappedBytes;
+        chunk->mappedBytes = mappedBytes;
+        return ptrToMem;
+    }
+
+    void *newPtr = allocate_aligned(numBytes, alignment);
+    if(newPtr != nullptr)
+    {
+        memcpy(newPtr, ptrToMem, chunk->mappedBytes - headerBytes);
+        free(ptrToMem);
+    }
+    return newPtr;
+}
+
+/********************************************************************************
+*   Function:   mapAligned                                                      *
+*   Parameters: size_t numBytes, size_t alignment, size_t offset                *
+*   Return Value: void*                                                         *
+*   Description: maps numBytes bytes (rounded up to whole pages) starting       *
+*                offset bytes below a multiple of alignment. alignment and      *
+*                offset are multiples of ARENA_ALIGNMENT. mmap only promises    *
+*                page alignment, so alignment extra bytes are mapped and the    *
+*                unaligned head and the leftover tail are unmapped again.       *
+********************************************************************************/
+void* ArenaHeap::mapAligned(size_t numBytes, size_t alignment, size_t offset)
+{
+    numBytes = roundToPages(numBytes);
+    size_t reservedBytes = numBytes + alignment;
+    void *reserved = mmap(nullptr, reservedBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(reserved == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    uintptr_t begin = (uintptr_t)reserved;
+    uintptr_t aligned = ((begin + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - offset;
+    uintptr_t end = begin + reservedBytes;
+    if(aligned != begin)
+    {
+        munmap(reserved, aligned - begin);
+    }
+    if(aligned + numBytes != end)
+    {
+        munmap((void*)(aligned + numBytes), end - aligned - numBytes);
+    }
+    return (void*)aligned;
+}
+
+/********************************************************************************
+*   Function:   mappingOf                                                       *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: void*                                                         *
+*   Description: returns the arena or large chunk that the block at ptrToMem    *
+*                was handed out from: the multiple of ARENA_ALIGNMENT below it. *
+********************************************************************************/
+void* ArenaHeap::mappingOf(void *ptrToMem)
+{
+    return (void*)(((uintptr_t)ptrToMem - 1) & ~(uintptr_t)(ARENA_ALIGNMENT - 1));
+}
@@ -0,0 +1,58 @@
+#ifndef _ArenaHeap_hpp
+#define _ArenaHeap_hpp
+#include "BoundaryTag.hpp"
+#include <stddef.h>
+
+// A heap that grows by mapping additional BoundaryTag arenas from the OS whenever the arenas it already has cannot
+// satisfy a request. Every arena keeps its own boundary tags and free bins. Arenas that become completely free are
+// handed back to the OS, so the resident size of the heap follows the amount of live memory. Requests too large for
+// an arena are given a mapping of their own.
+class ArenaHeap {
+    enum { ARENA_ALIGNMENT = 65536, LARGE_THRESHOLD = 4096, MAX_ARENA_PROBES = 4, ARENA = 1, LARGE_CHUNK = 2 };
+public:
+    ArenaHeap();
+    ~ArenaHeap();
+    void* allocate(size_t numBytes); // allocate a block of memory with "numBytes" bytes
+    void* allocate_aligned(size_t numBytes, size_t alignment); // allocate "numBytes" bytes starting at a multiple of "alignment"
+    void free(void *ptrToMem);       // recycle the memory that "ptrToMem" points to.
+    // resize a block, in place when its arena or mapping allows it; a block that has to move keeps "alignment".
+    void* reallocate(void *ptrToMem, size_t numBytes, size_t alignment = sizeof(BoundaryTag::Word));
+    size_t usableSize(void *ptrToMem); // number of bytes the caller may use at "ptrToMem".
+    int numArenas();
+    size_t mappedBytes();            // bytes currently mapped from the OS, including large chunks.
+
+private:
+    // Every mapping starts with kind, so free can tell an arena from a large chunk by rounding the pointer down to
+    // ARENA_ALIGNMENT. A block never starts at its mapping, so the byte before it is rounded down instead; that keeps
+    // blocks aligned to ARENA_ALIGNMENT or more from finding themselves.
+    struct Arena {
+        int kind;
+        Arena *prev;
+        Arena *next;
+        BoundaryTag tags;
+    };
+    struct LargeChunk {
+        int kind;
+        size_t mappedBytes;
+        LargeChunk *prev;
+        LargeChunk *next;
+    };
+
+    Arena *arenas;      // most recently used arena first.
+    Arena *spare;       // an empty arena kept mapped so a heap at the edge of an arena does not map and unmap;
+                        // allocate turns to it before mapping, wherever it has sunk to in the list.
+    LargeChunk *largeChunks;
+    int arenaCount;
+    size_t totalMapped;
+
+    Arena* emptyArena();
+    Arena* mapArena();
+    void unmapArena(Arena *arena);
+    void moveToFront(Arena *arena);
+    void* allocateLarge(size_t numBytes, size_t alignment);
+    void* reallocateLarge(LargeChunk *chunk, void *ptrToMem, size_t numBytes, size_t alignment);
+    void* mapAligned(size_t numBytes, size_t alignment, size_t offset);
+    static void* mappingOf(void *ptrToMem);
+};
+
+#endif
@@ -1,740 +1,1694 @@
 #include "BoundaryTag.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 /********************************************************************************
-*   Function:   BoundaryTag                                                     *
+*   Function:   BasicBoundaryTag                                                *
 *   Parameters: None                                                            *
 *   Return Value: None                                                          *
-*   Description: Initializes the freeIdx and iterIdx to the start of memory,    *
-*                sets the initial boundary tags of memory, and sets the         *
-*                previous and next pointers to null, respectively.              *
+*   Description: Initializes iterIdx to the start of memory, empties every      *
+*                free bin, sets the initial boundary tags of memory and places  *
+*                the single free space that spans all of memory in its bin.     *
 ********************************************************************************/
-BoundaryTag::BoundaryTag()
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+BasicBoundaryTag<CapacityBytes, TagWord, Policy>::BasicBoundaryTag()
 {
-    freeIdx = 0;
     iterIdx = 0;
+    binMap = 0;
+    rover = -1;
+    treeRoot = -1;
+    numParked = 0;
+    counters = Stats();
+    freshLimit = SIZE;
     //make sure all of memory is clean.
     for(int i = 0; i < SIZE; i++)
     {
         memory[i] = 0;
     }
+    for(int i = 0; i < NUM_BINS; i++)
+    {
+        freeBins[i] = -1;
+    }
+    for(int i = 0; i < QUICK_LIMIT; i++)
+    {
+        quickLists[i] = -1;
+    }
 
-    memory[0] = SIZE * -1;
-    memory[SIZE - 1] = SIZE * -1;
-    memory[1] = -1;
-    memory[2] = -1;
+    setTags(0, SIZE, FREE_BIT);
+    insertFree(0);
 }
 
 /********************************************************************************
 *   Function:   allocate                                                        *
-*   Parameters: int numBytes                                                    *
+*   Parameters: size_t numBytes                                                 *
 *   Retun Value: void *ptrToMemBlock                                            *
 *   Description: Allocates a specified number of bytes to memory. Creates the   *
 *                 overhead for the boundary tags within memory and returns the  *
 *                 address of the first available position that has been         *
 *                 allocated.                                                    *
 ********************************************************************************/
-void* BoundaryTag::allocate(int numBytes)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::allocate(size_t numBytes)
 {
-    //initialize the iterator to begin a search through memory.
-    internalStart();
-    //Create a pointer to a memory block, starting at the first free index.
-    void *ptrToMemBlock = &memory[freeIdx];
-    int allocatedSpace = (ceil(numBytes / 4.0) + 2) * 4;
+    //Reject anything larger than all of memory before rounding, so the word count below cannot overflow.
+    if(numBytes > SIZE * BYTES_PER_WORD)
+    {
+        return nullptr;
+    }
+    //Round up to whole words with a shift, then add the two boundary tags (and the magic word and canary with
+    //HEAP_CHECKS).
+    Word allocatedSpace = ((numBytes + BYTES_PER_WORD - 1) >> WORD_SHIFT) + HEADER_WORDS + TRAILER_WORDS;
 
-    if(DEBUG)
+    if(allocatedSpace < FREE_OVERHEAD)
     {
-        std::cout << "calling allocate" << std::endl;
-        std::cout << "ptrToMemBlock: " << ptrToMemBlock << std::endl;
-        std::cout << "numBytes: " << numBytes << std::endl;
+        return nullptr;
     }
 
-    if(allocatedSpace < 16)
+    //A parked block of exactly the right size can be handed straight back out.
+    if constexpr(DEFERRED_COALESCING)
     {
-        if(DEBUG)
+        if(allocatedSpace < QUICK_LIMIT && quickLists[allocatedSpace] != -1)
         {
-            std::cout << "space to allocate is not enough to store a free space. No allocation will occur. \n Attempted allocated space: " << allocatedSpace << std::endl;
+            Word index = quickLists[allocatedSpace];
+            quickLists[allocatedSpace] = memory[index + 1];
+            numParked--;
+            counters.numAllocates++;
+            counters.bytesInUse += allocatedSpace * BYTES_PER_WORD;
+            trace(HeapTrace::ALLOCATE, index, allocatedSpace, numBytes);
+            return handOut(index, numBytes);
         }
+    }
+
+    //Find a free space that is large enough to hold the allocation. If there are none, coalesce any parked blocks
+    //and try again. If there are still none, we are out of memory.
+    Word index = findFit(allocatedSpace);
+    if(DEFERRED_COALESCING && index == -1 && numParked > 0)
+    {
+        coalesceParked();
+        index = findFit(allocatedSpace);
+    }
+    if(index == -1)
+    {
         return nullptr;
     }
+    removeFree(index);
+    Word freeSpace = spaceWords(index);
 
-    //While there are still free spaces, continue to the next free space.
-    do
+    //If the value of the available space minus the allocated space is not enough to store a new free space, then
+    //include the remaining space with the allocated space.
+    if(freeSpace - allocatedSpace < FREE_OVERHEAD)
     {
-        //If the current pointer to a free space has a size less than or equal to that of the number of bytes to allocate, then
-        //allocate that number of bytes at the pointer to free space.
-        if(internalSize(ptrToMemBlock) >= allocatedSpace / 4 && SIZE - allocatedSpace / 4 >= 16)
+        setTags(index, freeSpace, 0);
+        memory[index + 1] = 0;
+        memory[index + 2] = 0;
+        counters.numAllocates++;
+        counters.bytesInUse += freeSpace * BYTES_PER_WORD;
+        if(index < freshLimit)
         {
-            allocatedSpace /= 4;
-
-            if(DEBUG)
-            {
-                std::cout << "iterIdx: " << iterIdx << std::endl;
-                std::cout << "memory[" << iterIdx << "]: " << memory[iterIdx] << std::endl;
-                std::cout << "ceil(numBytes / 4): " << ceil(numBytes / 4.0) << std::endl;
-                std::cout << "allocatedSpace: " << allocatedSpace << std::endl;
-                std::cout << "memory[" << abs(memory[iterIdx]) - 1 << "] before updating: " << memory[abs(memory[iterIdx]) - 1] << std::endl;
-                std::cout << "memory[" << iterIdx + 1 << "] before updating: " << memory[iterIdx + 1] << std::endl;
-                std::cout << "memory[" << iterIdx + 2 << "] before updating: " << memory[iterIdx + 2] << std::endl;
-                std::cout << "memory[" << iterIdx << "] before updating: " << memory[iterIdx] << std::endl;
-                std::cout << std::endl;
-            }
-
-            //Go to the boundary of the current free space and update its value to that of the newly allocated space.
-            memory[iterIdx + abs(memory[iterIdx]) - 1] = allocatedSpace;
-
-            //If the value of the available space minus the allocated space is not enough to store a new value, then include
-            //the remaining space with the allocated space and upate the freeIdx to the next available position, if there is any.
-            if(abs(memory[iterIdx]) - allocatedSpace < 4)
-            {
-                memory[iterIdx] *= -1;
-                memory[memory[iterIdx] - 1] = memory[iterIdx];
-                //As long as the current free space has a next pointer, set the freeIdx to that pointer and update
-                //that pointer's previous pointer to null since it is now the start of the array.
-                if(memory[iterIdx + 2] != -1)
-                {
-                    freeIdx = memory[iterIdx + 2];
-                    memory[freeIdx + 1] = -1;
-                }
-                memory[iterIdx + 1] = 0;
-                memory[iterIdx + 2] = 0;
-
-                return memory + iterIdx + 1;
-            }
-            else
-            {
-                //Go to the location of the beginning of the newly allocated space and set that to its allocated space value.
-                memory[iterIdx + abs(memory[iterIdx]) - allocatedSpace] = allocatedSpace;
-                //Go to the new boundary of the current free space and update that value to the remaining free space.
-                memory[iterIdx + abs(memory[iterIdx]) - allocatedSpace - 1] = (abs(memory[iterIdx]) - allocatedSpace) * -1;
-                //Update the beginning of the free space to have its new remaining space.
-                memory[iterIdx] = (abs(memory[iterIdx]) - allocatedSpace) * -1;
-            }
-            
-            if(DEBUG)
-            {
-                int allocatedIndex = abs(memory[iterIdx]) + 1;
-                std::cout << "memory[" << iterIdx << "] = " << memory[iterIdx] << std::endl;
-                std::cout << "memory[" << abs(memory[iterIdx]) - 1 << "] = " << memory[abs(memory[iterIdx]) - 1] << std::endl;
-                std::cout << "memory[" << abs(memory[iterIdx]) << "] = " << memory[abs(memory[iterIdx])] << std::endl;
-                std::cout << "returned address - memory = " << (iterIdx + abs(memory[iterIdx]) + 1);
-                std::cout << std::endl;
-            }
-            return memory + (iterIdx + abs(memory[iterIdx]) + 1);
+            freshLimit = index;
         }
+        trace(HeapTrace::ALLOCATE, index, freeSpace, numBytes);
+        return handOut(index, numBytes);
     }
-    while(ptrToMemBlock = internalNext());
-    if(DEBUG)
+
+    //Otherwise carve the allocated space off the end of the free space, update the boundaries of the remaining free
+    //space and put it back into the bin for its new size.
+    Word remainingSpace = freeSpace - allocatedSpace;
+    setTags(index, remainingSpace, FREE_BIT);
+    setTags(index + remainingSpace, allocatedSpace, 0);
+    insertFree(index);
+    counters.numAllocates++;
+    counters.bytesInUse += allocatedSpace * BYTES_PER_WORD;
+    if(index + remainingSpace < freshLimit)
     {
-        std::cout << "allocated nothing, no free spaces." << std::endl;
-        std::cout << std::endl;
+        freshLimit = index + remainingSpace;
     }
-    return nullptr;
+    trace(HeapTrace::SPLIT, index, remainingSpace, allocatedSpace);
+    trace(HeapTrace::ALLOCATE, index + remainingSpace, allocatedSpace, numBytes);
+
+    return handOut(index + remainingSpace, numBytes);
 }
 
 /********************************************************************************
-*   Function:   free                                                            *
-*   Parameters: void *ptrToMem                                                  *
-*   Retun Value: None                                                           *
-*   Description: frees ptrToMem from memory. First updates the boundary tags of *
-*                the allocated space to denote that it is free space. If the    *
-*                freed space can be coalesced with either adjacent space, then  *
-*                the newly freed space will attempt to coalesce with them. If   *
-*                the newly freed space cannot coalesce with either adjacent     *
-*                space, then the newly freed space will set its next and        *
-*                previous pointers.                                             *
+*   Function:   allocate_aligned                                                *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: Allocates numBytes bytes whose address is a multiple of        *
+*                alignment, which must be a power of two. Alignments of up to   *
+*                FREE_OVERHEAD words are carved off the end of a free space as  *
+*                allocate does, with the block's start moved down to the        *
+*                alignment; the few words that costs stay in the block. Larger  *
+*                alignments find a free space with enough room for the worst    *
+*                case slack, place the block at the first aligned position in   *
+*                it, and put the slack in front of and behind the block back in *
+*                the free bins whenever it is large enough to hold a free space.*
 ********************************************************************************/
-void BoundaryTag::free(void *ptrToMem)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::allocate_aligned(size_t numBytes, size_t alignment)
 {
-    //create a pointerIndex to the location of the freed memory and set the index to its proper position within memory.
-    int* pointerIndex = (int*)ptrToMem;
-    int index = pointerIndex - memory - 1;
-
-    if(DEBUG)
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        return nullptr;
+    }
+    //Every block already starts on a word boundary.
+    if(alignment <= BYTES_PER_WORD)
     {
-        std::cout << "calling free" << std::endl;
-        std::cout << "pointerIndex: " << pointerIndex << std::endl;
-        std::cout << "index: " << index << std::endl;
-        std::cout << "memory[" << index << "] = " << memory[index] << std::endl;
-        std::cout << std::endl;
+        return allocate(numBytes);
+    }
+    if(numBytes > SIZE * BYTES_PER_WORD || alignment > SIZE * BYTES_PER_WORD)
+    {
+        return nullptr;
     }
-    
-    //Update the size overhead at the end of the allocated space to notifiy that it is now free.
-    memory[index + memory[index] - 1] *= -1;
-    //Update the size overhead at the beginning of the allocated space to notify that it is now free.
-    memory[index] *= -1;
 
-    //Run through the entire free pool until you get to the end, all the while keeping track of the previous iterIdx.
-    internalStart();
-    void *ptrToMemBlock = &freeIdx;
-    int previousIndex = freeIdx;
-    while(ptrToMemBlock = internalNext())
+    Word allocatedSpace = ((numBytes + BYTES_PER_WORD - 1) >> WORD_SHIFT) + HEADER_WORDS + TRAILER_WORDS;
+    if(allocatedSpace < FREE_OVERHEAD)
+    {
+        allocatedSpace = FREE_OVERHEAD;
+    }
+    Word alignmentWords = alignment / BYTES_PER_WORD;
+    if(alignmentWords <= FREE_OVERHEAD)
     {
-        if(ptrToMemBlock != nullptr && iterIdx != -1)
+        void *ptrToMem = allocateAtEnd(numBytes, allocatedSpace, alignment);
+        if(ptrToMem != nullptr)
         {
-            previousIndex = iterIdx;
+            return ptrToMem;
         }
     }
 
-    //Set the next pointer at the previous last free space to that of the new free space.
-    memory[previousIndex + 2] = index;
-    //Set the previous pointer at the new free space to that of the previous free space.
-    memory[index + 1] = previousIndex;
-    //Set the next pointer at the new free space to -1 to indicate that it is the last.
-    memory[index + 2] = -1;
-
-
-    //If the left and right adjacent memory can be coalesced, then coalesce.
-    if((index != 0 && index + abs(memory[index]) != SIZE) && memory[index - 1] < 0 && memory[index + abs(memory[index])] < 0){
-        leftRightCoalesce(index, index - abs(memory[index - 1]), index + abs(memory[index]));
-    }
-    //If the left adjacent memory space can be coalesced, then coalsece.
-    else if(index != 0 && memory[index - 1] < 0)
+    //The block may have to move up to alignment - 1 bytes into the free space, plus FREE_OVERHEAD more words if the
+    //slack in front of it would be too small to hold a free space of its own.
+    Word index = findFit(allocatedSpace + alignmentWords + FREE_OVERHEAD);
+    if(DEFERRED_COALESCING && index == -1 && numParked > 0)
     {
-        leftCoalesce(index, index - abs(memory[index - 1]));
+        coalesceParked();
+        index = findFit(allocatedSpace + alignmentWords + FREE_OVERHEAD);
     }
-    //If the right adjacent memory space can be coalesced, then coalesce.
-    else if((index + abs(memory[index])) != SIZE && memory[index + abs(memory[index])] < 0)
+    if(index == -1)
     {
-        rightCoalesce(index, index + abs(memory[index]));
+        //A smaller space may still fit if it happens to be well placed, so check every free space exactly.
+        for(Word current = 0; current < SIZE; current += spaceWords(current))
+        {
+            if(spaceIsFree(current) && alignedStart(current, alignment) + allocatedSpace <= current + spaceWords(current))
+            {
+                index = current;
+                break;
+            }
+        }
+        if(index == -1)
+        {
+            return nullptr;
+        }
     }
-    
-    if(DEBUG)
+    removeFree(index);
+    Word freeSpace = spaceWords(index);
+    Word blockIndex = alignedStart(index, alignment);
+
+    Word leadingSpace = blockIndex - index;
+    Word trailingSpace = freeSpace - leadingSpace - allocatedSpace;
+    if(trailingSpace < FREE_OVERHEAD)
     {
-        std::cout << "previousIndex = " << previousIndex << std::endl;
-        std::cout << "memory[" << index << "] = " << memory[index] << std::endl;
-        std::cout << "memory[" << index + abs(memory[index]) - 1 << "] = " << memory[index + abs(memory[index]) - 1] << std::endl;
-        std::cout << "memory[" << index + 1 << "] = " << memory[index + 1] << std::endl;
-        std::cout << "memory[" << index + 2 << "] = " << memory[index + 2] << std::endl;
-        std::cout << "memory[" << previousIndex + 2 << "] (new space's prev's next pointer) = " << memory[previousIndex + 2] << std::endl;
-        std::cout << std::endl;
+        allocatedSpace += trailingSpace;
+        trailingSpace = 0;
     }
-}
 
-/********************************************************************************
-*   Function:   leftCoalesce                                                    *
-*   Parameters: int currentLeftBoundary, int coalesceLeftBoundary               *
-*   Retun Value: None                                                           *
-*   Description: coalesces the current space being freed with the left adjacent *
-*                space. Removes the current pointer to the left boundary on the *
-*                second to last memory, frees the overhead of the current left  *
-*                boundary and the coalesced space's right boundary, as well as  *
-*                removes the current space's overhead for previous and next     *
-*                pointers, as it was the last in the linked list.               *
-********************************************************************************/
-void BoundaryTag::leftCoalesce(int &currentLeftBoundary, int coalesceLeftBoundary)
-{
-    if(DEBUG)
+    //The spaces on either side of the original free space are allocated, since free spaces are always coalesced, so
+    //the slack can go straight back into the bins.
+    if(leadingSpace > 0)
     {
-        std::cout << "calling leftCoalesce" << std::endl;
-        std::cout << "currentLeftBoundary = " << currentLeftBoundary << std::endl;
-        std::cout << "coalesceLeftBoundary = " << coalesceLeftBoundary << std::endl;
+        setTags(index, leadingSpace, FREE_BIT);
+        insertFree(index);
+        trace(HeapTrace::SPLIT, index, leadingSpace, allocatedSpace);
     }
-
-    //Set newBoundaryValue to the sum of the currentLeftBoundary and the and coalesceLeftBoundary after signifying it is an available space.
-    int newBoundaryValue = (abs(memory[currentLeftBoundary]) + abs(memory[coalesceLeftBoundary])) * -1;
-    //Set the right boundary of the newly coalesced space to the newBoundaryValue.
-    memory[currentLeftBoundary + abs(memory[currentLeftBoundary]) - 1] = newBoundaryValue;
-    //Set the left boundary of the newly coalesced space to the newBoundaryValue.
-    memory[coalesceLeftBoundary] = newBoundaryValue;
-    //Set the next pointer on the currently freed space's previous pointer to null since the memory has been coalesced into another space.
-    memory[memory[currentLeftBoundary + 1] + 2] = -1;
-
-    //Remove the extra unnecessary overhead from the coalesced space.
-    memory[currentLeftBoundary - 1] = 0;
-    memory[currentLeftBoundary] = 0;
-    memory[currentLeftBoundary + 1] = 0;
-    memory[currentLeftBoundary + 2] = 0;
-
-    if(DEBUG)
+    if(trailingSpace > 0)
+    {
+        setTags(blockIndex + allocatedSpace, trailingSpace, FREE_BIT);
+        insertFree(blockIndex + allocatedSpace);
+        trace(HeapTrace::SPLIT, blockIndex + allocatedSpace, trailingSpace, allocatedSpace);
+    }
+    setTags(blockIndex, allocatedSpace, 0);
+    counters.numAllocates++;
+    counters.bytesInUse += allocatedSpace * BYTES_PER_WORD;
+    if(blockIndex < freshLimit)
     {
-        std::cout << "memory[" << coalesceLeftBoundary << "] = " << memory[coalesceLeftBoundary] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary + 1 << "] = " << memory[coalesceLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary + 2 << "] = " << memory[coalesceLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary - 1 << "] = " << memory[currentLeftBoundary] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary << "] = " << memory[currentLeftBoundary] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 1 << "] = " << memory[currentLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 2 << "] = " << memory[currentLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << abs(memory[coalesceLeftBoundary]) - 1 << "] = " << memory[abs(memory[coalesceLeftBoundary]) - 1 ] << std::endl;
-        std::cout << std::endl;
+        freshLimit = blockIndex;
     }
+    trace(HeapTrace::ALLOCATE, blockIndex, allocatedSpace, numBytes);
 
-    //Update the current left boundary to refer to the newly coalesced left boundary position. This is useful when
-    //performing a right coalescence, as the index used for currentLeftBoundary would be out of date when performing a
-    //right coalescence.
-    currentLeftBoundary = coalesceLeftBoundary;
+    return handOut(blockIndex, numBytes);
 }
 
 /********************************************************************************
-*   Function:   rightCoalesce                                                   *
-*   Parameters: int currentLeftBoundary, int coalesceLeftBoundary               *
-*   Retun Value: None                                                           *
-*   Description: coalesces the current space being freed with the right adjacent*
-*                space. Removes the current pointer to the left boundary on the *
-*                second to last memory, frees the overhead of the coalesced     *
-*                boundary and the current boundary's right boundary.            *
+*   Function:   allocateAtEnd                                                   *
+*   Parameters: size_t numBytes, Word allocatedSpace, size_t alignment          *
+*   Return Value: void*                                                         *
+*   Description: carves a block of at least allocatedSpace words whose caller's *
+*                bytes start at a multiple of alignment off the end of a free   *
+*                space. The block starts at the last aligned position that      *
+*                leaves it allocatedSpace words, so it holds at most            *
+*                alignment / BYTES_PER_WORD - 1 words more than that, and only  *
+*                the space in front of it goes back in the bins. If that would  *
+*                be too small to be free, the block starts at the front of the  *
+*                space instead when that is aligned. Returns nullptr if no      *
+*                space fits or neither place works.                             *
 ********************************************************************************/
-void BoundaryTag::rightCoalesce(int currentLeftBoundary, int coalesceLeftBoundary)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::allocateAtEnd(size_t numBytes, Word allocatedSpace, size_t alignment)
 {
-    //Set newBoundaryValue to the sum of the currentLeftBoundary and the and coalesceLeftBoundary after signifying it is an available space.
-    int newBoundaryValue = (abs(memory[currentLeftBoundary]) + abs(memory[coalesceLeftBoundary])) * -1;
-
-    if(DEBUG)
+    Word index = findFit(allocatedSpace + alignment / BYTES_PER_WORD - 1);
+    if(index == -1)
     {
-        std::cout << "calling rightCoalesce" << std::endl;
-        std::cout << "currentLeftBoundary = " << currentLeftBoundary << std::endl;
-        std::cout << "coalesceLeftBoundary = " << coalesceLeftBoundary << std::endl;
-        std::cout << "newBoundaryValue = " << newBoundaryValue << std::endl;
+        return nullptr;
+    }
+    Word freeSpace = spaceWords(index);
+    Word blockIndex = index + freeSpace - allocatedSpace;
+    blockIndex -= ((uintptr_t)(memory + blockIndex + HEADER_WORDS) & (alignment - 1)) >> WORD_SHIFT;
+    Word remainingSpace = blockIndex - index;
+    if(remainingSpace > 0 && remainingSpace < FREE_OVERHEAD)
+    {
+        //Too little is left in front to free. If the front of the space is aligned too, the block takes all of it.
+        if(remainingSpace % (alignment / BYTES_PER_WORD) != 0)
+        {
+            return nullptr;
+        }
+        blockIndex = index;
+        remainingSpace = 0;
     }
 
-    //Set the right boundary of the newly coalesced space to the newBoundaryValue.
-    memory[coalesceLeftBoundary + abs(memory[coalesceLeftBoundary]) - 1] = newBoundaryValue;
-    //Set the left boundary of the newly coalesced space to the newBoundaryValue.
-    memory[currentLeftBoundary] = newBoundaryValue;
-
-    //Set the next pointer of the coalesced spaces's previous pointer to that of the coalesced space's next pointer.
-    memory[memory[coalesceLeftBoundary + 1] + 2] = currentLeftBoundary;
-    //Set the previous pointer of the coalesced space's next pointer to that of the current space.
-    memory[memory[coalesceLeftBoundary + 2] + 1] = currentLeftBoundary;
-    //Set the next pointer of the current space's previous pointer to null, since it should no longer point to the coalesced space.
-    memory[memory[currentLeftBoundary + 1] + 2] = -1;
-
-    //Set the previous pointer of the newly coalesced memory to that of the coalesced space's previous pointer.
-    memory[currentLeftBoundary + 1] = memory[coalesceLeftBoundary + 1];
-    //Set the next pointer of the newly coalesced memory to that of the coalesced space's next pointer.
-    memory[currentLeftBoundary + 2] = memory[coalesceLeftBoundary + 2];
-
-    //If the next pionter of the newly coalesced memory points to any of the given boundaries, set the
-    //next pointer to null since it was pointing to itself.
-    if(memory[currentLeftBoundary + 2] == currentLeftBoundary || memory[currentLeftBoundary + 2] == coalesceLeftBoundary)
+    removeFree(index);
+    Word blockSpace = freeSpace - remainingSpace;
+    if(remainingSpace > 0)
     {
-        memory[currentLeftBoundary + 2] = -1;
+        setTags(index, remainingSpace, FREE_BIT);
+        insertFree(index);
+        trace(HeapTrace::SPLIT, index, remainingSpace, blockSpace);
     }
-    
-    //If the freeIdx currently points to the coalesced space, then set the freeIdx to the newly coalesced space.
-    if(freeIdx == coalesceLeftBoundary)
+    else
+    {
+        memory[index + 1] = 0;
+        memory[index + 2] = 0;
+    }
+    setTags(blockIndex, blockSpace, 0);
+    counters.numAllocates++;
+    counters.bytesInUse += blockSpace * BYTES_PER_WORD;
+    if(blockIndex < freshLimit)
     {
-        freeIdx = currentLeftBoundary;
+        freshLimit = blockIndex;
     }
+    trace(HeapTrace::ALLOCATE, blockIndex, blockSpace, numBytes);
 
-    //Remove the extra unnecessary overhead from the coalesced space.
-    memory[coalesceLeftBoundary - 1] = 0;
-    memory[coalesceLeftBoundary] = 0;
-    memory[coalesceLeftBoundary + 1] = 0;
-    memory[coalesceLeftBoundary + 2] = 0;
+    return handOut(blockIndex, numBytes);
+}
 
-    if(DEBUG)
+/********************************************************************************
+*   Function:   alignedStart                                                    *
+*   Parameters: Word index, size_t alignment                                    *
+*   Return Value: Word                                                          *
+*   Description: returns the first position for a left boundary in the free     *
+*                space at index at which the block after it is aligned and the  *
+*                slack in front is either empty or big enough to be a free      *
+*                space. The slack is rounded up to the alignment, and then up   *
+*                by whole alignment steps until it is at least FREE_OVERHEAD    *
+*                words, so no word is visited.                                  *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::alignedStart(Word index, size_t alignment)
+{
+    Word alignmentWords = alignment / BYTES_PER_WORD;
+    uintptr_t start = (uintptr_t)(memory + index + HEADER_WORDS);
+    Word slack = (((start + alignment - 1) & ~(uintptr_t)(alignment - 1)) - start) >> WORD_SHIFT;
+    if(slack != 0 && slack < FREE_OVERHEAD)
     {
-        std::cout << "memory[" << currentLeftBoundary << "] = " << memory[currentLeftBoundary] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 1 << "] = " << memory[currentLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 2 << "] = " << memory[currentLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary - 1 << "] = " << memory[coalesceLeftBoundary - 1 ] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary << "] = " << memory[coalesceLeftBoundary] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary + 1 << "] = " << memory[coalesceLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << coalesceLeftBoundary + 2 << "] = " << memory[coalesceLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + abs(memory[currentLeftBoundary]) - 1 << "] = " << memory[currentLeftBoundary + abs(memory[currentLeftBoundary]) - 1] << std::endl;
-        std::cout << "memory[" << abs(memory[currentLeftBoundary + 1]) + 2 << "] = " << memory[abs(memory[currentLeftBoundary + 1]) + 2] << std::endl;
-        std::cout << std::endl;
+        slack += (FREE_OVERHEAD - slack + alignmentWords - 1) / alignmentWords * alignmentWords;
     }
+    return index + slack;
 }
 
 /********************************************************************************
-*   Function:   leftRightCoalesce                                               *
-*   Parameters: int currentLeftBoundary, int leftCoalesceLeftBoundary,          *
-*               int rightCoalesceRightBoundary                                  *
-*   Retun Value: None                                                           *
-*   Description: coalesces the current space being freed with both the left and *
-*                right adjacent memory spaces. If the left coalesced space's    *
-*                next pointer points to the current space, the newly coalesced  *
-*                memory will use the right coalesced space's and vice versa.    *
-*                Otherwise, the newly coalesced space will use the left         *
-*                coalesced space's previous pointer, the right coalesced space's*
-*                next pointer, set the current space's previous pointer to null,*
-*                and free the unnecessary overhead from the coalesced spaces.   *
+*   Function:   allocate_batch                                                  *
+*   Parameters: size_t numBytes, size_t count, void *out[]                      *
+*   Return Value: size_t                                                        *
+*   Description: allocates up to count blocks of numBytes bytes each into out   *
+*                and returns how many were allocated. Each search looks for one *
+*                free space that holds every block still wanted, settling for   *
+*                one that holds at least one, and carves as many blocks as fit  *
+*                off its end in one pass, in address order. A batch that fits   *
+*                in one space costs a single search and a single bin update.    *
+*                Parked blocks are not reused, but are coalesced when no space  *
+*                fits.                                                          *
 ********************************************************************************/
-void BoundaryTag::leftRightCoalesce(int &currentLeftBoundary, int leftCoalesceLeftBoundary, int rightCoalesceLeftBoundary)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+size_t BasicBoundaryTag<CapacityBytes, TagWord, Policy>::allocate_batch(size_t numBytes, size_t count, void *out[])
 {
-    
-
-    //Set newBoundaryValue to the sum of the currentLeftBoundary and the and coalesceLeftBoundary after signifying it is an available space.
-    int newBoundaryValue = (abs(memory[currentLeftBoundary]) + abs(memory[leftCoalesceLeftBoundary]) + abs(memory[rightCoalesceLeftBoundary])) * -1;
-
-    if(DEBUG)
+    if(numBytes > SIZE * BYTES_PER_WORD)
     {
-        std::cout << "calling leftRightCoalesce" << std::endl;
-        std::cout << "currentLeftBoundary = " << currentLeftBoundary << std::endl;
-        std::cout << "leftCoalesceLeftBoundary = " << leftCoalesceLeftBoundary << std::endl;
-        std::cout << "rightCoalesceLeftBoundary = " << rightCoalesceLeftBoundary << std::endl;
-        std::cout << "newBoundaryValue = " << newBoundaryValue << std::endl;
-        std::cout << std::endl;
+        return 0;
+    }
+    Word allocatedSpace = ((numBytes + BYTES_PER_WORD - 1) >> WORD_SHIFT) + HEADER_WORDS + TRAILER_WORDS;
+    if(allocatedSpace < FREE_OVERHEAD)
+    {
+        return 0;
     }
 
-    //Set the right boundary of the newly coalesced space to that of the newBoundaryValue.
-    memory[rightCoalesceLeftBoundary + abs(memory[rightCoalesceLeftBoundary]) - 1] = newBoundaryValue;
-    //Set the left boundary of the newly coalesced space to that of the newBoundaryValue.
-    memory[leftCoalesceLeftBoundary] = newBoundaryValue;
-
-    //If the left coalesced space's next pointer is the currentLeftBoundary, use the right coalesced space's pointers.
-    if(memory[leftCoalesceLeftBoundary + 2] == currentLeftBoundary)
+    size_t numAllocated = 0;
+    while(numAllocated < count)
     {
-        if(DEBUG)
+        size_t wanted = count - numAllocated;
+        Word index = findFit(wanted < (size_t)(SIZE / allocatedSpace) ? wanted * allocatedSpace : (size_t)SIZE);
+        if(index == -1)
         {
-            std::cout << "left coalesce's next == current" << std::endl;
+            index = findFit(allocatedSpace);
         }
-        
-        //First update the next pointer of the left coalesced space's previous pointer to null.
-        memory[memory[leftCoalesceLeftBoundary + 1] + 2] = -1;
-        memory[leftCoalesceLeftBoundary + 1] = memory[rightCoalesceLeftBoundary + 1];
-        memory[leftCoalesceLeftBoundary + 2] = memory[rightCoalesceLeftBoundary + 2];
-        
-        //Update the previous pointer of the newly coalesced memory's next pointer to the newly coalesced space,
-        //as long as leftCoalesceLeftBoundary's next pointer is not null, as this can cause issues when coalescing
-        //the memory back to being completely free.
-        if(memory[leftCoalesceLeftBoundary + 2] != -1)
+        if(DEFERRED_COALESCING && index == -1 && numParked > 0)
         {
-            memory[memory[leftCoalesceLeftBoundary + 2] + 1] = leftCoalesceLeftBoundary;
+            coalesceParked();
+            continue;
         }
-
-        //Update the next pointer of the newly coalesced memory's previous pointer to the newly coalesced space,
-        //as long as leftCoalesceLeftBoundary's previous pointer is not null, as this can cause issues when coalescing
-        //the memory back to being completely free.
-        if(memory[leftCoalesceLeftBoundary + 1] != -1)
+        if(index == -1)
         {
-            memory[memory[leftCoalesceLeftBoundary + 1] + 2] = leftCoalesceLeftBoundary; 
+            break;
         }
-    }
-    //If the right coalesced space's next pointer is currentLeftBoundary, use the left coalesced space's pointers.
-    //We only need to update the next pointer of the right coalesced space's previous pointer to null since the newly
-    //coalesced memory already uses the left coalesced space's pointers.
-    else if(memory[rightCoalesceLeftBoundary + 2] == currentLeftBoundary)
-    {
-        if(DEBUG)
+        removeFree(index);
+        Word freeSpace = spaceWords(index);
+        Word numBlocks = std::min(wanted, (size_t)(freeSpace / allocatedSpace));
+
+        //The blocks go at the end of the free space. If what is left in front of them is too small to be a free space,
+        //the first block takes it, as allocate does.
+        Word remainingSpace = freeSpace - numBlocks * allocatedSpace;
+        Word block = index + remainingSpace;
+        Word firstSpace = allocatedSpace;
+        if(remainingSpace < FREE_OVERHEAD)
         {
-            std::cout << "right coalesce's next == current" << std::endl;
+            block = index;
+            firstSpace += remainingSpace;
+            memory[index + 1] = 0;
+            memory[index + 2] = 0;
         }
-        memory[memory[rightCoalesceLeftBoundary + 1] + 2] = -1;
-    }
-    //Otherwise, use the left coalseced space's previous pointer and the right coalesced space's next pointer.
-    else
-    {
-        if(DEBUG)
+        else
         {
-            std::cout << "none of the above, normal leftRightCoalesce" << std::endl;
+            setTags(index, remainingSpace, FREE_BIT);
+            insertFree(index);
+            trace(HeapTrace::SPLIT, index, remainingSpace, numBlocks * allocatedSpace);
         }
-
-        //If the previous pointer of leftCoalesceLeftBoundary points to rightCoalesceLeftBoundary, use rightCoalesceLeftBoundary's
-        //previous pointer and update the next pointer of the newly coalesced space's previous pointer to the proper position.
-        if(memory[leftCoalesceLeftBoundary + 1] == rightCoalesceLeftBoundary)
+        if(block < freshLimit)
         {
-            memory[leftCoalesceLeftBoundary + 1] = memory[rightCoalesceLeftBoundary + 1];
-            memory[memory[leftCoalesceLeftBoundary + 1] + 2] = leftCoalesceLeftBoundary;
+            freshLimit = block;
         }
 
-        //As long as the next pointer of rightCoalesceLeftBoundary doesn't point to leftCoalesceLeftBoundary, set the
-        //next pointer of the newly coalesced space to the next pointer of the rightCoalesceLeftBoundary and update the
-        //previous pinter of the newly coalesced space to point to its current position.
-        if(memory[rightCoalesceLeftBoundary + 2] != leftCoalesceLeftBoundary)
+        for(Word i = 0; i < numBlocks; i++)
         {
-            memory[leftCoalesceLeftBoundary + 2] = memory[rightCoalesceLeftBoundary + 2];
-            memory[memory[leftCoalesceLeftBoundary + 2] + 1] = leftCoalesceLeftBoundary;
+            Word blockSpace = i == 0 ? firstSpace : allocatedSpace;
+            setTags(block, blockSpace, 0);
+            counters.bytesInUse += blockSpace * BYTES_PER_WORD;
+            trace(HeapTrace::ALLOCATE, block, blockSpace, numBytes);
+            out[numAllocated++] = handOut(block, numBytes);
+            block += blockSpace;
         }
-        
-        //Update the next pointer of the current space's previous pointer to null, since it is now the last free space.
-        memory[memory[currentLeftBoundary + 1] + 2] = -1;
+        counters.numAllocates += numBlocks;
     }
+    return numAllocated;
+}
 
-    if(DEBUG)
+/********************************************************************************
+*   Function:   reallocate                                                      *
+*   Parameters: void *ptrToMem, size_t numBytes                                 *
+*   Return Value: void*                                                         *
+*   Description: resizes the block ptrToMem points to so it holds numBytes      *
+*                bytes and returns where it now is. The block is resized in     *
+*                place with resizeInPlace when it can be. Only otherwise is a   *
+*                new block allocated and the contents copied. A null ptrToMem   *
+*                is an allocate and a numBytes of 0 is a free. If there is no   *
+*                room, nullptr is returned and the old block is left as it was. *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::reallocate(void *ptrToMem, size_t numBytes)
+{
+    if(ptrToMem == nullptr)
     {
-        std::cout << "memory[" << leftCoalesceLeftBoundary << "] = " << memory[leftCoalesceLeftBoundary] << std::endl;
-        std::cout << "memory[" << rightCoalesceLeftBoundary + abs(memory[rightCoalesceLeftBoundary]) - 1 << "] = " << memory[rightCoalesceLeftBoundary + abs(memory[rightCoalesceLeftBoundary]) - 1] << std::endl;
-        std::cout << std::endl;
+        return allocate(numBytes);
     }
-
-
-    //If the newly coalesced memory's previous pointer points to any of the given left boundaries, then
-    //set it to null as it is now pointing to itself.
-    if(memory[leftCoalesceLeftBoundary + 1] == currentLeftBoundary || memory[leftCoalesceLeftBoundary + 1] == leftCoalesceLeftBoundary || memory[leftCoalesceLeftBoundary + 1] == rightCoalesceLeftBoundary)
+    if(numBytes == 0)
+    {
+        free(ptrToMem);
+        return nullptr;
+    }
+    if(numBytes > SIZE * BYTES_PER_WORD)
     {
-        memory[leftCoalesceLeftBoundary + 1] = -1;
+        return nullptr;
     }
-    //If the newly coalesced memory's next pointer points to any of the given left boundaries, then
-    //set it to null as it is now pointing to itself.
-    if(memory[leftCoalesceLeftBoundary + 2] == currentLeftBoundary || memory[leftCoalesceLeftBoundary + 2] == leftCoalesceLeftBoundary || memory[leftCoalesceLeftBoundary + 2] == rightCoalesceLeftBoundary)
+    if(resizeInPlace(ptrToMem, numBytes))
     {
-        memory[leftCoalesceLeftBoundary + 2] = -1;
+        return ptrToMem;
     }
 
+    void *newPtr = allocate(numBytes);
+    if(newPtr == nullptr)
+    {
+        return nullptr;
+    }
+    memcpy(newPtr, ptrToMem, usableSize(ptrToMem));
+    free(ptrToMem);
+    return newPtr;
+}
 
-    //If the freeIdx was pointing to the right coalesced space, we need to change it to point to the new beginning
-    //of the newly coalesced space. We don't need to check the leftCoalesced space as that is already the beginning
-    //of the newly coalesced space.
-    if(freeIdx == rightCoalesceLeftBoundary)
+/********************************************************************************
+*   Function:   resizeInPlace                                                   *
+*   Parameters: void *ptrToMem, size_t numBytes                                 *
+*   Return Value: bool                                                          *
+*   Description: resizes the block ptrToMem points to so it holds numBytes      *
+*                bytes without moving it. A shrinking block gives its tail back *
+*                as a free space. A growing block takes in the free space to    *
+*                its right with rightCoalesce if that is big enough. Returns    *
+*                false, leaving the block as it was, if it cannot grow there.   *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::resizeInPlace(void *ptrToMem, size_t numBytes)
+{
+    if(numBytes > SIZE * BYTES_PER_WORD)
     {
-        freeIdx = leftCoalesceLeftBoundary;
+        return false;
     }
 
+    Word index = blockIndex(ptrToMem);
+    if constexpr(HEAP_CHECKS)
+    {
+        const char *problem = blockProblem(index);
+        if(problem != nullptr)
+        {
+            checkFailed(problem, ptrToMem);
+        }
+    }
+    Word oldSpace = spaceWords(index);
+    Word newSpace = ((numBytes + BYTES_PER_WORD - 1) >> WORD_SHIFT) + HEADER_WORDS + TRAILER_WORDS;
+    if(newSpace < FREE_OVERHEAD)
+    {
+        newSpace = FREE_OVERHEAD;
+    }
 
-    //Remove the extra unnecessary overhead from the coalesced space.
-    memory[currentLeftBoundary - 1] = 0;
-    memory[currentLeftBoundary] = 0;
-    memory[currentLeftBoundary + 1] = 0;
-    memory[currentLeftBoundary + 2] = 0;
-    memory[rightCoalesceLeftBoundary - 1] = 0;
-    memory[rightCoalesceLeftBoundary] = 0;
-    memory[rightCoalesceLeftBoundary + 1] = 0;
-    memory[rightCoalesceLeftBoundary + 2] = 0;
+    if(newSpace <= oldSpace)
+    {
+        shrinkInPlace(index, newSpace);
+        counters.bytesInUse -= (oldSpace - spaceWords(index)) * BYTES_PER_WORD;
+        trace(HeapTrace::RESIZE, index, spaceWords(index), oldSpace);
+        handOut(index, numBytes);
+        return true;
+    }
 
-    if(DEBUG)
-    {
-        std::cout << "memory[" << leftCoalesceLeftBoundary << "] = " << memory[leftCoalesceLeftBoundary] << std::endl;
-        std::cout << "memory[" << leftCoalesceLeftBoundary + 1 << "] = " << memory[leftCoalesceLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << leftCoalesceLeftBoundary + 2 << "] = " << memory[leftCoalesceLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary - 1 << "] = " << memory[currentLeftBoundary - 1] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary << "] = " << memory[currentLeftBoundary] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 1 << "] = " << memory[currentLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << currentLeftBoundary + 2 << "] = " << memory[currentLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << rightCoalesceLeftBoundary - 1 << "] = " << memory[rightCoalesceLeftBoundary - 1] << std::endl;
-        std::cout << "memory[" << rightCoalesceLeftBoundary << "] = " << memory[rightCoalesceLeftBoundary] << std::endl;
-        std::cout << "memory[" << rightCoalesceLeftBoundary + 1 << "] = " << memory[rightCoalesceLeftBoundary + 1] << std::endl;
-        std::cout << "memory[" << rightCoalesceLeftBoundary + 2 << "] = " << memory[rightCoalesceLeftBoundary + 2] << std::endl;
-        std::cout << "memory[" << leftCoalesceLeftBoundary + abs(memory[leftCoalesceLeftBoundary]) - 1 << "] = " << memory[leftCoalesceLeftBoundary + abs(memory[leftCoalesceLeftBoundary]) - 1] << std::endl;
-        std::cout << "memory[" << memory[leftCoalesceLeftBoundary + 1] + 2 << "] = " << memory[memory[leftCoalesceLeftBoundary + 1] + 2] << std::endl;
-        std::cout << "memory[" << memory[leftCoalesceLeftBoundary + 2] + 1 << "] = " << memory[memory[leftCoalesceLeftBoundary + 2] + 1] << std::endl;
-        std::cout << "memory[" << memory[leftCoalesceLeftBoundary + 2] + 2 << "] = " << memory[memory[leftCoalesceLeftBoundary + 2] + 2] << std::endl;
-        std::cout << "memory[" << memory[rightCoalesceLeftBoundary + 1] + 2 << "] = " << memory[memory[rightCoalesceLeftBoundary + 1] + 2] << std::endl;
-        std::cout << "memory[" << memory[rightCoalesceLeftBoundary + 2] + 1 << "] = " << memory[memory[rightCoalesceLeftBoundary + 2] + 1] << std::endl;
-        std::cout << "memory[" << memory[rightCoalesceLeftBoundary + 2] + 2 << "] = " << memory[memory[rightCoalesceLeftBoundary + 2] + 2] << std::endl;
-        std::cout << "memory[" << memory[currentLeftBoundary + 1] << "] = " << memory[memory[currentLeftBoundary + 1]] << std::endl;
-        std::cout << "freeIdx = " << freeIdx << std::endl;
-        std::cout << std::endl;
+    Word rightIndex = index + oldSpace;
+    if(rightIndex != SIZE && spaceIsFree(rightIndex) && oldSpace + spaceWords(rightIndex) >= newSpace)
+    {
+        //rightCoalesce leaves the merged space tagged free, and shrinkInPlace tags the front of it allocated again.
+        rightCoalesce(index, rightIndex);
+        shrinkInPlace(index, newSpace);
+        counters.bytesInUse += (spaceWords(index) - oldSpace) * BYTES_PER_WORD;
+        trace(HeapTrace::RESIZE, index, spaceWords(index), oldSpace);
+        handOut(index, numBytes);
+        return true;
     }
+    return false;
 }
 
 /********************************************************************************
-*   Function:   start                                                           *
-*   Parameters: None                                                            *
-*   Retun Value: None                                                           *
-*   Description: resets iterIdx to 0, which is the first space the driver will  *
-*                check when asserting memory size.                              *
+*   Function:   callocate                                                       *
+*   Parameters: size_t numElements, size_t elementBytes                         *
+*   Return Value: void*                                                         *
+*   Description: allocates room for numElements elements of elementBytes bytes  *
+*                each, all set to zero. Memory below freshLimit has never been  *
+*                handed out and is still zero from the constructor, so a block  *
+*                carved entirely from there is not cleared again.               *
 ********************************************************************************/
-void BoundaryTag::start()
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::callocate(size_t numElements, size_t elementBytes)
 {
-    if(DEBUG)
+    if(elementBytes != 0 && numElements > SIZE_MAX / elementBytes)
     {
-        std::cout << "calling start" << std::endl;
-        std::cout << "freeIdx: " << freeIdx << std::endl;
-        std::cout << "memory[freeIdx]: " << memory[freeIdx] << std::endl;
-        std::cout <<"memory[0]: " << memory[0] << std::endl;
-        std::cout << std::endl;
+        return nullptr;
     }
-    iterIdx = 0;
+    size_t numBytes = numElements * elementBytes;
+
+    Word oldFreshLimit = freshLimit;
+    void *ptrToMem = allocate(numBytes);
+    if(ptrToMem == nullptr)
+    {
+        return nullptr;
+    }
+
+    Word index = blockIndex(ptrToMem);
+    if(index + spaceWords(index) > oldFreshLimit)
+    {
+        memset(ptrToMem, 0, numBytes);
+    }
+    return ptrToMem;
 }
 
 /********************************************************************************
-*   Function:   next                                                            *
-*   Parameters: None                                                            *
-*   Retun Value: void*                                                          *
-*   Description: the external use of next for the driver. If the iterIdx and    *
-*                freeIdx are at the same position, then return the first free   *
-*                space. If the next position is at the end of memory, return    *
-*                nullptr. Otherwise, return the next free space. Traverses      *
-*                memory based on distance to next adjacent space instead of only*
-*                traversing through free spaces.                                *
+*   Function:   shrinkInPlace                                                   *
+*   Parameters: Word index, Word newSpace                                       *
+*   Return Value: None                                                          *
+*   Description: tags the space at index as an allocated space of newSpace      *
+*                words. If what is left after it is big enough to be a free     *
+*                space, it is freed and coalesced with any free space to its    *
+*                right. Otherwise the space keeps its current size.             *
 ********************************************************************************/
-void* BoundaryTag::next()
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::shrinkInPlace(Word index, Word newSpace)
 {
-if(DEBUG)
+    Word oldSpace = spaceWords(index);
+    if(oldSpace - newSpace < FREE_OVERHEAD)
+    {
+        setTags(index, oldSpace, 0);
+        return;
+    }
+
+    Word tailIndex = index + newSpace;
+    setTags(index, newSpace, 0);
+    setTags(tailIndex, oldSpace - newSpace, FREE_BIT);
+    if(index + oldSpace != SIZE && spaceIsFree(index + oldSpace))
     {
-        std::cout << "calling next" << std::endl;
+        rightCoalesce(tailIndex, index + oldSpace);
     }
+    insertFree(tailIndex);
+    trace(HeapTrace::SPLIT, tailIndex, spaceWords(tailIndex), newSpace);
+}
 
-    if(iterIdx == freeIdx && freeIdx == 0)
+/********************************************************************************
+*   Function:   free                                                            *
+*   Parameters: void *ptrToMem                                                  *
+*   Retun Value: None                                                           *
+*   Description: frees ptrToMem from memory. With DEFERRED_COALESCING, a small  *
+*                block is parked on the quick list for its size with its tags   *
+*                left as they are, and coalesced later by coalesceParked.       *
+*                Anything else is released straight away.                       *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::free(void *ptrToMem)
+{
+    //Find the left boundary of the space being freed.
+    Word index = blockIndex(ptrToMem);
+    if constexpr(HEAP_CHECKS)
     {
-        if(DEBUG)
+        const char *problem = blockProblem(index);
+        if(problem != nullptr)
         {
-            std::cout << "iterIdx == freeIdx && freeIdx == 0" << std::endl;
-            std::cout << "iterIdx before = " << iterIdx << std::endl;
-            std::cout << "iterIdx after = " << abs(memory[iterIdx]) << std::endl;
-            std::cout << "freeIdx = " << freeIdx << std::endl;
-            std::cout << "memory[" << freeIdx << "] = " << memory[freeIdx] << std::endl;
-            std::cout << std::endl;
+            checkFailed(problem, ptrToMem);
         }
-        
-        iterIdx = abs(memory[iterIdx]);
-        return &memory[freeIdx];
     }
-    else if(iterIdx >= SIZE || abs(memory[iterIdx]) == 0)
+
+    Word numWords = spaceWords(index);
+    counters.numFrees++;
+    counters.bytesInUse -= numWords * BYTES_PER_WORD;
+    trace(HeapTrace::FREE, index, numWords, 0);
+
+    //A parked block still looks allocated to its neighbours, so nothing coalesces with it until it is released.
+    if constexpr(DEFERRED_COALESCING)
     {
-        if(DEBUG)
-       {
-        std::cout << "about to return nullptr." << std::endl;
-        std::cout << "iterIdx = " << iterIdx << std::endl;
-        std::cout << "memory[" << iterIdx << "] = " << memory[iterIdx] << std::endl;
-        std::cout << std::endl;
-       }
-        return nullptr;
+        if(numWords < QUICK_LIMIT)
+        {
+            memory[index + 1] = quickLists[numWords];
+            quickLists[numWords] = index;
+            if(++numParked >= MAX_PARKED)
+            {
+                coalesceParked();
+            }
+            return;
+        }
     }
-    else
-    {
-        int returnedValue = iterIdx;
-        iterIdx += abs(memory[iterIdx]);
-        return &memory[returnedValue];
-    }    
+    release(index);
 }
 
 /********************************************************************************
-*   Function:   isFree                                                          *
-*   Parameters: void *ptrToMem                                                  *
-*   Retun Value: Bool                                                           *
-*   Description: checks to see whether pointer to memory contains a space that  *
-*                is free or not.                                                *
+*   Function:   free_batch                                                      *
+*   Parameters: void *ptrs[], size_t count                                      *
+*   Return Value: None                                                          *
+*   Description: frees count blocks at once, reordering ptrs by address. Runs   *
+*                of blocks that sit next to each other are joined into one      *
+*                space first, so each run is coalesced with its neighbours and  *
+*                put in a bin only once. nullptr entries are skipped. Blocks    *
+*                are never parked, since they are being coalesced in a batch    *
+*                already.                                                       *
 ********************************************************************************/
-bool BoundaryTag::isFree(void *ptrToMem)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::free_batch(void *ptrs[], size_t count)
 {
-    //create a pointerIndex to the location of the freed memory and set the index to its proper position within memory.
-    int *pointerIndex = (int*)ptrToMem;
-    int index = pointerIndex - memory - 1;
-    //If the address of ptrToMem in memory is positive, return true, else false.
-    if(memory[index] < 0)
+    std::sort(ptrs, ptrs + count);
+
+    size_t i = 0;
+    while(i < count && ptrs[i] == nullptr)
     {
-        return true;
+        i++;
     }
-    else
+    if constexpr(HEAP_CHECKS)
     {
-        return false;
+        for(size_t j = i; j < count; j++)
+        {
+            const char *problem = j > i && ptrs[j] == ptrs[j - 1] ? "freed twice in one batch" : blockProblem(blockIndex(ptrs[j]));
+            if(problem != nullptr)
+            {
+                checkFailed(problem, ptrs[j]);
+            }
+        }
+    }
+
+    while(i < count)
+    {
+        Word runStart = blockIndex(ptrs[i]);
+        Word runSpace = spaceWords(runStart);
+        counters.numFrees++;
+        counters.bytesInUse -= runSpace * BYTES_PER_WORD;
+        trace(HeapTrace::FREE, runStart, runSpace, 0);
+
+        //Absorb every following block that starts where the run ends, clearing the tags between them.
+        for(i++; i < count && blockIndex(ptrs[i]) == runStart + runSpace; i++)
+        {
+            Word index = runStart + runSpace;
+            Word numWords = spaceWords(index);
+            counters.numFrees++;
+            counters.numCoalesces++;
+            counters.bytesInUse -= numWords * BYTES_PER_WORD;
+            trace(HeapTrace::FREE, index, numWords, 0);
+            memory[index - 1] = 0;
+            memory[index] = 0;
+            memory[index + 1] = 0;
+            runSpace += numWords;
+            trace(HeapTrace::COALESCE, runStart, runSpace, index);
+        }
+        setTags(runStart, runSpace, 0);
+        release(runStart);
     }
 }
 
 /********************************************************************************
-*   Function:   size                                                            *
-*   Parameters: void *ptr                                                       *
-*   Retun Value: int                                                            *
-*   Description: returns the size in bytes of the given pointer in memory.      *
+*   Function:   release                                                         *
+*   Parameters: Word index                                                      *
+*   Return Value: None                                                          *
+*   Description: First updates the boundary tags of the allocated space at      *
+*                index to denote that it is free space. If the freed space can  *
+*                be coalesced with either adjacent space, then the newly freed  *
+*                space will attempt to coalesce with them. Finally, the         *
+*                resulting free space is pushed onto the bin for its size. The  *
+*                adjacent spaces are found through their boundary tags and      *
+*                unlinked through their own pointers, so release never walks a  *
+*                free list and runs in constant time.                           *
 ********************************************************************************/
-int BoundaryTag::size(void *ptr)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::release(Word index)
 {
-    int *pointerIndex = (int*)ptr;
-    int index = pointerIndex - memory;
-    
-    if(DEBUG)
+    //Set the free bit in the size overhead at both ends of the allocated space to notify that it is now free.
+    Word numWords = spaceWords(index);
+    setTags(index, numWords, FREE_BIT);
+
+    //The right boundary of the left adjacent space sits just before this space, and the left boundary of the right
+    //adjacent space just after it. The edges of memory have no neighbour.
+    bool leftIsFree = index != 0 && (memory[index - 1] & FREE_BIT);
+    bool rightIsFree = index + numWords != SIZE && spaceIsFree(index + numWords);
+
+    //If the left and right adjacent memory can be coalesced, then coalesce.
+    if(leftIsFree && rightIsFree)
     {
-        std::cout << "calling size" << std::endl;
-        std::cout << "index: " << index << std::endl;
-        std::cout << "size: " << abs(memory[index]) * BYTES_PER_WORD << std::endl;
-        std::cout << std::endl;
+        leftRightCoalesce(index, index - (memory[index - 1] >> WORD_SHIFT), index + numWords);
     }
-    return abs(memory[index]) * BYTES_PER_WORD;
+    //If the left adjacent memory space can be coalesced, then coalsece.
+    else if(leftIsFree)
+    {
+        leftCoalesce(index, index - (memory[index - 1] >> WORD_SHIFT));
+    }
+    //If the right adjacent memory space can be coalesced, then coalesce.
+    else if(rightIsFree)
+    {
+        rightCoalesce(index, index + numWords);
+    }
+
+    //Place the (possibly coalesced) free space in the bin for its size.
+    insertFree(index);
+
 }
 
 /********************************************************************************
-*   Function:   internalSize                                                    *
-*   Parameters: void *ptr                                                       *
-*   Retun Value: int                                                            *
-*   Description: returns the size of the given pointer in memory. These pointers*
-*                refer to the location of the left boundary tag and indicate    *
-*                the available number of index spaces wihtin memory.            *
+*   Function:   handOut                                                         *
+*   Parameters: Word index, size_t numBytes                                     *
+*   Return Value: void*                                                         *
+*   Description: returns the pointer given to the caller for the allocated      *
+*                space at index. With HEAP_CHECKS it first writes the magic     *
+*                word and fills everything after the caller's numBytes bytes up *
+*                to the right boundary with the canary.                         *
 ********************************************************************************/
-int BoundaryTag::internalSize(void *ptrToMem)
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::handOut(Word index, size_t numBytes)
 {
-    int *pointerIndex = (int*)ptrToMem;
-    int index = pointerIndex - memory;
-    if(DEBUG)
+    if constexpr(HEAP_CHECKS)
     {
-        std::cout << "calling internal size" << std::endl;
-        std::cout << "index: " << index << std::endl;
-        std::cout << "internal size: " << abs(memory[index]) << std::endl;
-        std::cout << std::endl;
+        memory[index + 1] = CHECK_MAGIC | (Word)numBytes;
+        unsigned char *redzone = (unsigned char*)(memory + index + HEADER_WORDS) + numBytes;
+        memset(redzone, CANARY_BYTE, (unsigned char*)(memory + index + spaceWords(index) - 1) - redzone);
     }
-    return abs(memory[index]);
+    return memory + index + HEADER_WORDS;
 }
 
 /********************************************************************************
-*   Function:   interalNext                                                     *
-*   Parameters: None                                                            *
-*   Retun Value: void*                                                          *
-*   Description: the internal use of next for keeping track of free spaces. If  *
-*                the freeIdx and the iterIdx are equal, then return the first   *
-*                space. If the next free space is null, then return nullptr.    *
-*                Otherwise returns the address of the next free space in        *
-*                memory.                                                        *
+*   Function:   blockProblem                                                    *
+*   Parameters: Word index                                                      *
+*   Return Value: const char*                                                   *
+*   Description: checks that index is the left boundary of an allocated space   *
+*                handed out with HEAP_CHECKS: its tags are those of an allocated*
+*                space and agree, its magic word is intact and its canary has   *
+*                not been written over. Returns what is wrong, or nullptr if    *
+*                nothing is. A freed space has the free bit set, no tags left   *
+*                or no magic word left, so a double free is caught here too.    *
+*                Writes in front of the block are told apart by which of the    *
+*                tags and the magic word survived.                              *
 ********************************************************************************/
-void *BoundaryTag::internalNext()
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+const char* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::blockProblem(Word index)
 {
-    if(DEBUG)
+    //The magic word is read before the size is trusted, so the header has to fit in the heap.
+    if(index < 0 || index + HEADER_WORDS > SIZE)
     {
-        std::cout << "calling internalNext" << std::endl;
-        std::cout << "iterIdx before updating: " << iterIdx << std::endl;
+        return "pointer outside of the heap";
     }
-    
-    //If the freeIdx is pointing to a nullptr, then we have exhausted our available free spaces and there is no need
-    //to check any further.
-    if(freeIdx == -1)
+    Word numWords = spaceWords(index);
+    bool tagsAgree = numWords >= HEADER_WORDS + TRAILER_WORDS && index + numWords <= SIZE &&
+                     memory[index + numWords - 1] == memory[index];
+    bool magicIntact = (memory[index + 1] & MAGIC_MASK) == CHECK_MAGIC;
+    if(spaceIsFree(index) || (!tagsAgree && !magicIntact))
     {
-        if(DEBUG)
-        {
-            std::cout << "returning nullptr, no more free spaces." << std::endl;
-        }
-        return nullptr;
+        return "double free, or a pointer that was not allocated";
     }
-
-    //If the freeIdx is equal to iterIdx, then update iterIdx and return freeIdx.
-    //Else if the next free space is null, then return nullptr. Otherwise, increment iterIdx and return iterIdx.
-    if(freeIdx == iterIdx)
+    if(!tagsAgree)
     {
-        iterIdx = memory[iterIdx + 2];
-        
-        if(DEBUG)
-        {
-            std::cout << "freeIdx == iterIdx" << std::endl;
-            std::cout << "iterIdx after updating: " << iterIdx << std::endl;
-            std::cout << "memory[freeIdx address] - memory : " << &memory[freeIdx] - memory << std::endl;
-            std::cout << std::endl;
-        }
-        return &memory[freeIdx];
+        return "boundary tags written over";
     }
-    else if(memory[iterIdx + 2] == -1 || iterIdx < 0 || iterIdx > SIZE)
+    //A parked block keeps its tags, but its magic word holds the link to the next parked block.
+    if(!magicIntact)
     {
-        
-        if(DEBUG)
-        {
-            std::cout << "returning nullptr, no more free spaces." << std::endl;
-            std::cout << std::endl;
-        }
-        
-        return nullptr;
+        return DEFERRED_COALESCING ? "double free of a parked block, or header written over" : "header written over";
     }
-    else
+
+    size_t numBytes = memory[index + 1] & ~MAGIC_MASK;
+    unsigned char *redzone = (unsigned char*)(memory + index + HEADER_WORDS) + numBytes;
+    unsigned char *end = (unsigned char*)(memory + index + numWords - 1);
+    for(; redzone < end; redzone++)
     {
-        iterIdx = memory[iterIdx + 2];
-        
-        if(DEBUG)
+        if(*redzone != CANARY_BYTE)
         {
-            std::cout << "iterIdx after updating: " << iterIdx << std::endl;
-            std::cout << "iterIdx as a void*: " << &iterIdx << std::endl;
-            std::cout << "iterIdx as a void* - memory: " << &iterIdx - memory << std::endl;
-            std::cout << "memory[iterIdx + 2]: " << memory[iterIdx + 2] << std::endl;
-            std::cout << std::endl;
+            return "write past the end of the block";
         }
-        return &memory[iterIdx];
     }
+    return nullptr;
 }
 
 /********************************************************************************
-*   Function:   interalStart                                                    *
-*   Parameters: None                                                            *
-*   Retun Value: None                                                           *
-*   Description: the internal use of start for setting iterIdx to the proper    *
-*                position before iterating through the free spaces. Freeidx may *
-*                not always be 0, and as such iterIdx shouldn't start at the    *
-*                beginning of the array when searching for a free space.        *
+*   Function:   checkFailed                                                     *
+*   Parameters: const char *problem, void *ptrToMem                             *
+*   Return Value: None                                                          *
+*   Description: reports a problem HEAP_CHECKS found with ptrToMem and aborts,  *
+*                since the heap can no longer be trusted. With HEAP_TRACE, the  *
+*                events that led up to it are dumped to heap.trace first.       *
 ********************************************************************************/
-void BoundaryTag::internalStart()
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::checkFailed(const char *problem, void *ptrToMem)
 {
-    if(DEBUG)
+    std::cerr << "BoundaryTag: " << problem << " at " << ptrToMem << std::endl;
+    if(HEAP_TRACE && HeapTrace::dump("heap.trace"))
     {
-        std::cout << "calling internal start" << std::endl;
-        std::cout << "iterIdx = " << iterIdx << std::endl;
-        std::cout << "freeIdx = " << freeIdx << std::endl;
-        
+        std::cerr << "The last heap events were written to heap.trace." << std::endl;
     }
-    iterIdx = freeIdx;
-}
\ No newline at end of file
+    abort();
+}
+
+/********************************************************************************
+*   Function:   coalesceParked                                                  *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: releases every parked block, coalescing it with its neighbours *
+*                and placing the result in the bins, so that the tags describe  *
+*                every free space again.                                        *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::coalesceParked()
+{
+    for(int numWords = FREE_OVERHEAD; numWords < QUICK_LIMIT; numWords++)
+    {
+        while(quickLists[numWords] != -1)
+        {
+            Word index = quickLists[numWords];
+            quickLists[numWords] = memory[index + 1];
+            release(index);
+        }
+    }
+    numParked = 0;
+}
+
+/********************************************************************************
+*   Function:   leftCoalesce                                                    *
+*   Parameters: Word currentLeftBoundary, Word coalesceLeftBoundary             *
+*   Retun Value: None                                                           *
+*   Description: coalesces the current space being freed with the left adjacent *
+*                space. Removes the left adjacent space from its bin, since its *
+*                size is about to change, sets the boundaries of the newly      *
+*                coalesced space and frees the overhead of the current left     *
+*                boundary and the coalesced space's right boundary.             *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::leftCoalesce(Word &currentLeftBoundary, Word coalesceLeftBoundary)
+{
+    removeFree(coalesceLeftBoundary);
+    counters.numCoalesces++;
+
+    //Set newSpace to the sum of the sizes of the currentLeftBoundary and the coalesceLeftBoundary, and write it to
+    //the left boundary of the coalesced space and the right boundary of the current space.
+    Word newSpace = spaceWords(currentLeftBoundary) + spaceWords(coalesceLeftBoundary);
+    setTags(coalesceLeftBoundary, newSpace, FREE_BIT);
+
+    //Remove the extra unnecessary overhead from the coalesced space.
+    memory[currentLeftBoundary - 1] = 0;
+    memory[currentLeftBoundary] = 0;
+    memory[currentLeftBoundary + 1] = 0;
+    memory[currentLeftBoundary + 2] = 0;
+    trace(HeapTrace::COALESCE, coalesceLeftBoundary, newSpace, currentLeftBoundary);
+
+    //Update the current left boundary to refer to the newly coalesced left boundary position, so the caller places
+    //the right space into the free bins.
+    currentLeftBoundary = coalesceLeftBoundary;
+}
+
+/********************************************************************************
+*   Function:   rightCoalesce                                                   *
+*   Parameters: Word currentLeftBoundary, Word coalesceLeftBoundary             *
+*   Retun Value: None                                                           *
+*   Description: coalesces the current space being freed with the right adjacent*
+*                space. Removes the right adjacent space from its bin, sets the *
+*                boundaries of the newly coalesced space and frees the overhead *
+*                of the coalesced boundary and the current boundary's right     *
+*                boundary.                                                      *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::rightCoalesce(Word currentLeftBoundary, Word coalesceLeftBoundary)
+{
+    removeFree(coalesceLeftBoundary);
+    counters.numCoalesces++;
+
+    //Set newSpace to the sum of the sizes of the currentLeftBoundary and the coalesceLeftBoundary.
+    Word newSpace = spaceWords(currentLeftBoundary) + spaceWords(coalesceLeftBoundary);
+
+    //Write newSpace to the left boundary of the current space and the right boundary of the coalesced space.
+    setTags(currentLeftBoundary, newSpace, FREE_BIT);
+
+    //Remove the extra unnecessary overhead from the coalesced space.
+    memory[coalesceLeftBoundary - 1] = 0;
+    memory[coalesceLeftBoundary] = 0;
+    memory[coalesceLeftBoundary + 1] = 0;
+    memory[coalesceLeftBoundary + 2] = 0;
+    trace(HeapTrace::COALESCE, currentLeftBoundary, newSpace, coalesceLeftBoundary);
+}
+
+/********************************************************************************
+*   Function:   leftRightCoalesce                                               *
+*   Parameters: Word currentLeftBoundary, Word leftCoalesceLeftBoundary,        *
+*               Word rightCoalesceRightBoundary                                 *
+*   Retun Value: None                                                           *
+*   Description: coalesces the current space being freed with both the left and *
+*                right adjacent memory spaces. Both adjacent spaces are removed *
+*                from their bins, the left coalesced space's left boundary and  *
+*                the right coalesced space's right boundary are set to the new  *
+*                size, and the unnecessary overhead in between is freed.        *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::leftRightCoalesce(Word &currentLeftBoundary, Word leftCoalesceLeftBoundary, Word rightCoalesceLeftBoundary)
+{
+    removeFree(leftCoalesceLeftBoundary);
+    removeFree(rightCoalesceLeftBoundary);
+    counters.numCoalesces += 2;
+
+    //Set newSpace to the sum of the sizes of all three spaces.
+    Word newSpace = spaceWords(currentLeftBoundary) + spaceWords(leftCoalesceLeftBoundary) + spaceWords(rightCoalesceLeftBoundary);
+
+    //Write newSpace to the left boundary of the left space and the right boundary of the right space.
+    setTags(leftCoalesceLeftBoundary, newSpace, FREE_BIT);
+
+    //Remove the extra unnecessary overhead from the coalesced space.
+    memory[currentLeftBoundary - 1] = 0;
+    memory[currentLeftBoundary] = 0;
+    memory[currentLeftBoundary + 1] = 0;
+    memory[currentLeftBoundary + 2] = 0;
+    memory[rightCoalesceLeftBoundary - 1] = 0;
+    memory[rightCoalesceLeftBoundary] = 0;
+    memory[rightCoalesceLeftBoundary + 1] = 0;
+    memory[rightCoalesceLeftBoundary + 2] = 0;
+    trace(HeapTrace::COALESCE, leftCoalesceLeftBoundary, newSpace, currentLeftBoundary);
+    trace(HeapTrace::COALESCE, leftCoalesceLeftBoundary, newSpace, rightCoalesceLeftBoundary);
+
+    //Update the current left boundary to refer to the newly coalesced left boundary position.
+    currentLeftBoundary = leftCoalesceLeftBoundary;
+}
+
+/********************************************************************************
+*   Function:   binIndex                                                        *
+*   Parameters: Word numWords                                                   *
+*   Return Value: int                                                           *
+*   Description: returns the bin that a free space of numWords words belongs    *
+*                to. Small spaces share a bin with spaces one word larger or    *
+*                smaller, large spaces share a bin with every space in the same *
+*                power of two. The bins are kept for the free space histogram   *
+*                whatever the placement policy.                                 *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+int BasicBoundaryTag<CapacityBytes, TagWord, Policy>::binIndex(Word numWords)
+{
+    if(numWords < SMALL_BIN_LIMIT)
+    {
+        return numWords / 2;
+    }
+
+    //The first large bin starts at SMALL_BIN_LIMIT words, every bin after it covers the next power of two.
+    int bin = SMALL_BIN_LIMIT / 2 + std::bit_width((unsigned long long)numWords) - std::bit_width((unsigned long long)SMALL_BIN_LIMIT);
+    return bin < NUM_BINS ? bin : NUM_BINS - 1;
+}
+
+/********************************************************************************
+*   Function:   insertFree                                                      *
+*   Parameters: Word index                                                      *
+*   Return Value: None                                                          *
+*   Description: adds the free space at index to the free space structure of    *
+*                the placement policy. Under SEGREGATED_FIT it is pushed onto   *
+*                the front of the bin for its size and the bin is marked as     *
+*                non-empty in binMap. Spaces are kept in LIFO order, so no walk *
+*                of the bin is needed and the most recently freed (and likely   *
+*                still cached) space is reused first. FIRST_FIT and NEXT_FIT    *
+*                push it onto the one list the same way, ADDRESS_ORDERED walks  *
+*                the list to its place, and BEST_FIT inserts it into the tree.  *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::insertFree(Word index)
+{
+    int bin = binIndex(spaceWords(index));
+    counters.freeHistogram[bin]++;
+    counters.numFreeBlocks++;
+
+    if constexpr(placement == BEST_FIT)
+    {
+        treeRoot = treeInsert(treeRoot, index);
+        return;
+    }
+    if constexpr(placement != SEGREGATED_FIT)
+    {
+        bin = 0;
+    }
+
+    //The new space goes after previousIndex, which is the head of the list for every policy but ADDRESS_ORDERED.
+    Word previousIndex = -1;
+    Word nextIndex = freeBins[bin];
+    if constexpr(placement == ADDRESS_ORDERED)
+    {
+        while(nextIndex != -1 && nextIndex < index)
+        {
+            previousIndex = nextIndex;
+            nextIndex = memory[nextIndex + 2];
+        }
+    }
+
+    memory[index + 1] = previousIndex;
+    memory[index + 2] = nextIndex;
+    if(previousIndex == -1)
+    {
+        freeBins[bin] = index;
+    }
+    else
+    {
+        memory[previousIndex + 2] = index;
+    }
+    if(nextIndex != -1)
+    {
+        memory[nextIndex + 1] = index;
+    }
+    binMap |= 1ULL << bin;
+}
+
+/********************************************************************************
+*   Function:   removeFree                                                      *
+*   Parameters: Word index                                                      *
+*   Return Value: None                                                          *
+*   Description: takes the free space at index out of the free space structure  *
+*                of the placement policy. In a list it is unlinked by joining   *
+*                its previous and next pointers, and the bin's bit in binMap is *
+*                cleared if the bin is now empty. Must be called before the     *
+*                space's tags change, since its size says where it is kept.     *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::removeFree(Word index)
+{
+    int bin = binIndex(spaceWords(index));
+    counters.freeHistogram[bin]--;
+    counters.numFreeBlocks--;
+
+    if constexpr(placement == BEST_FIT)
+    {
+        treeRoot = treeRemove(treeRoot, index);
+        return;
+    }
+    if constexpr(placement != SEGREGATED_FIT)
+    {
+        bin = 0;
+    }
+
+    Word previousIndex = memory[index + 1];
+    Word nextIndex = memory[index + 2];
+    if constexpr(placement == NEXT_FIT)
+    {
+        if(rover == index)
+        {
+            rover = nextIndex;
+        }
+    }
+
+    if(previousIndex == -1)
+    {
+        freeBins[bin] = nextIndex;
+    }
+    else
+    {
+        memory[previousIndex + 2] = nextIndex;
+    }
+    if(nextIndex != -1)
+    {
+        memory[nextIndex + 1] = previousIndex;
+    }
+
+    if(freeBins[bin] == -1)
+    {
+        binMap &= ~(1ULL << bin);
+    }
+}
+
+/********************************************************************************
+*   Function:   findFit                                                         *
+*   Parameters: Word numWords                                                   *
+*   Return Value: Word                                                          *
+*   Description: returns the index of a free space that can hold numWords       *
+*                words, or -1 if there is none. Under SEGREGATED_FIT the bin for*
+*                numWords is searched first-fit, since it may hold spaces       *
+*                slightly smaller than numWords. Every space in a larger bin    *
+*                fits, so the first non-empty larger bin is found with a single *
+*                scan of binMap. FIRST_FIT and ADDRESS_ORDERED search the list  *
+*                from its head, NEXT_FIT from rover round to rover again, and   *
+*                BEST_FIT walks down the tree to the smallest space that fits.  *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::findFit(Word numWords)
+{
+    if constexpr(placement == BEST_FIT)
+    {
+        Word bestIndex = -1;
+        for(Word current = treeRoot; current != -1; )
+        {
+            if(spaceWords(current) >= numWords)
+            {
+                bestIndex = current;
+                current = memory[current + 1];
+            }
+            else
+            {
+                current = memory[current + 2];
+            }
+        }
+        return bestIndex;
+    }
+    else if constexpr(placement == NEXT_FIT)
+    {
+        Word startIndex = rover != -1 ? rover : freeBins[0];
+        for(Word current = startIndex; current != -1; current = memory[current + 2])
+        {
+            if(spaceWords(current) >= numWords)
+            {
+                rover = current;
+                return current;
+            }
+        }
+        for(Word current = freeBins[0]; current != startIndex; current = memory[current + 2])
+        {
+            if(spaceWords(current) >= numWords)
+            {
+                rover = current;
+                return current;
+            }
+        }
+        return -1;
+    }
+    else
+    {
+        int bin = placement == SEGREGATED_FIT ? binIndex(numWords) : 0;
+
+        for(Word current = freeBins[bin]; current != -1; current = memory[current + 2])
+        {
+            if(spaceWords(current) >= numWords)
+            {
+                return current;
+            }
+        }
+
+        if(placement != SEGREGATED_FIT || bin + 1 >= NUM_BINS)
+        {
+            return -1;
+        }
+        unsigned long long largerBins = binMap & (~0ULL << (bin + 1));
+        if(largerBins == 0)
+        {
+            return -1;
+        }
+        return freeBins[std::countr_zero(largerBins)];
+    }
+}
+
+/********************************************************************************
+*   Function:   treeInsert                                                      *
+*   Parameters: Word root, Word index                                           *
+*   Return Value: Word                                                          *
+*   Description: inserts the free space at index into the tree under root and   *
+*                returns the new root of that tree. The space goes in as a leaf *
+*                and is rotated up while its priority beats its parent's.       *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::treeInsert(Word root, Word index)
+{
+    if(root == -1)
+    {
+        memory[index + 1] = -1;
+        memory[index + 2] = -1;
+        return index;
+    }
+
+    if(treeLess(index, root))
+    {
+        Word left = treeInsert(memory[root + 1], index);
+        memory[root + 1] = left;
+        if(treePriority(left) > treePriority(root))
+        {
+            //Rotate right: the left child becomes the root, and the root takes its right subtree as its left.
+            memory[root + 1] = memory[left + 2];
+            memory[left + 2] = root;
+            return left;
+        }
+    }
+    else
+    {
+        Word right = treeInsert(memory[root + 2], index);
+        memory[root + 2] = right;
+        if(treePriority(right) > treePriority(root))
+        {
+            //Rotate left: the right child becomes the root, and the root takes its left subtree as its right.
+            memory[root + 2] = memory[right + 1];
+            memory[right + 1] = root;
+            return right;
+        }
+    }
+    return root;
+}
+
+/********************************************************************************
+*   Function:   treeRemove                                                      *
+*   Parameters: Word root, Word index                                           *
+*   Return Value: Word                                                          *
+*   Description: removes the free space at index from the tree under root and   *
+*                returns the new root of that tree. The space is found by its   *
+*                size and address, and its two subtrees are merged in its place.*
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::treeRemove(Word root, Word index)
+{
+    if(root == index)
+    {
+        return treeMerge(memory[root + 1], memory[root + 2]);
+    }
+    if(treeLess(index, root))
+    {
+        memory[root + 1] = treeRemove(memory[root + 1], index);
+    }
+    else
+    {
+        memory[root + 2] = treeRemove(memory[root + 2], index);
+    }
+    return root;
+}
+
+/********************************************************************************
+*   Function:   treeMerge                                                       *
+*   Parameters: Word left, Word right                                           *
+*   Return Value: Word                                                          *
+*   Description: joins two trees, where every space in left orders before every *
+*                space in right, and returns the root of the result. The root   *
+*                with the higher priority stays on top.                         *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::treeMerge(Word left, Word right)
+{
+    if(left == -1)
+    {
+        return right;
+    }
+    if(right == -1)
+    {
+        return left;
+    }
+    if(treePriority(left) > treePriority(right))
+    {
+        memory[left + 2] = treeMerge(memory[left + 2], right);
+        return left;
+    }
+    memory[right + 1] = treeMerge(left, memory[right + 1]);
+    return right;
+}
+
+/********************************************************************************
+*   Function:   start                                                           *
+*   Parameters: None                                                            *
+*   Retun Value: None                                                           *
+*   Description: resets iterIdx to 0, which is the first space the driver will  *
+*                check when asserting memory size.                              *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::start()
+{
+    //Parked blocks are tagged as allocated, so they are coalesced before anyone walks the tags.
+    if(numParked > 0)
+    {
+        coalesceParked();
+    }
+    iterIdx = 0;
+}
+
+/********************************************************************************
+*   Function:   next                                                            *
+*   Parameters: None                                                            *
+*   Retun Value: void*                                                          *
+*   Description: the external use of next for the driver. If the next position  *
+*                is at the end of memory, return nullptr. Otherwise, return the *
+*                next space. Traverses memory based on distance to next         *
+*                adjacent space instead of only traversing through free spaces. *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void* BasicBoundaryTag<CapacityBytes, TagWord, Policy>::next()
+{
+    if(iterIdx >= SIZE || memory[iterIdx] == 0)
+    {
+        return nullptr;
+    }
+    else
+    {
+        Word returnedValue = iterIdx;
+        iterIdx += spaceWords(iterIdx);
+        return &memory[returnedValue];
+    }    
+}
+
+/********************************************************************************
+*   Function:   spaces                                                          *
+*   Parameters: None                                                            *
+*   Return Value: Spaces                                                        *
+*   Description: returns the range of every space in memory, first to last.     *
+*                Unlike start and next, the position is kept in the iterators   *
+*                rather than in the heap. Parked blocks are coalesced first, as *
+*                in start.                                                      *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Spaces BasicBoundaryTag<CapacityBytes, TagWord, Policy>::spaces()
+{
+    if(numParked > 0)
+    {
+        coalesceParked();
+    }
+    return Spaces{this};
+}
+
+/********************************************************************************
+*   Function:   snapshot                                                        *
+*   Parameters: Snapshot &out                                                   *
+*   Return Value: None                                                          *
+*   Description: walks memory once and records the index, size and free bit of  *
+*                every space in out, without allocating. Parked blocks are      *
+*                coalesced first, as in start.                                  *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::snapshot(Snapshot &out)
+{
+    if(numParked > 0)
+    {
+        coalesceParked();
+    }
+
+    size_t numSpaces = 0;
+    for(Word index = 0; index < SIZE; index += spaceWords(index))
+    {
+        if(numSpaces % 64 == 0)
+        {
+            out.freeMap[numSpaces / 64] = 0;
+        }
+        out.index[numSpaces] = index;
+        out.numWords[numSpaces] = spaceWords(index);
+        out.freeMap[numSpaces / 64] |= (uint64_t)spaceIsFree(index) << (numSpaces % 64);
+        numSpaces++;
+    }
+    out.numSpaces = numSpaces;
+}
+
+/********************************************************************************
+*   Function:   isFree                                                          *
+*   Parameters: void *ptrToMem                                                  *
+*   Retun Value: Bool                                                           *
+*   Description: checks to see whether pointer to memory contains a space that  *
+*                is free or not.                                                *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::isFree(void *ptrToMem)
+{
+    //Find the left boundary of the space ptrToMem points into.
+    Word index = blockIndex(ptrToMem);
+    //If the free bit of the space's left boundary is set, return true, else false.
+    if(spaceIsFree(index))
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+/********************************************************************************
+*   Function:   isEmpty                                                         *
+*   Parameters: None                                                            *
+*   Return Value: bool                                                          *
+*   Description: returns true if nothing is allocated, which is the case when   *
+*                the first space is free and spans all of memory.               *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::isEmpty()
+{
+    //Memory can only be empty if every block left is parked.
+    if(numParked > 0 && counters.bytesInUse == 0)
+    {
+        coalesceParked();
+    }
+    return memory[0] == ((Word)SIZE << WORD_SHIFT | FREE_BIT);
+}
+
+/********************************************************************************
+*   Function:   trim                                                            *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: tells the OS that the whole pages inside every free space are  *
+*                no longer needed, so they stop counting towards the resident   *
+*                size until they are allocated again. The first FREE_OVERHEAD   *
+*                words and the right boundary of each space are left alone, as  *
+*                they hold the tags and free space pointers. The spaces are     *
+*                found by walking the tags, which works under every policy.     *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+void BasicBoundaryTag<CapacityBytes, TagWord, Policy>::trim()
+{
+    if(numParked > 0)
+    {
+        coalesceParked();
+    }
+    uintptr_t pageSize = sysconf(_SC_PAGESIZE);
+    for(Word current = 0; current < SIZE; current += spaceWords(current))
+    {
+        if(!spaceIsFree(current))
+        {
+            continue;
+        }
+        uintptr_t begin = (uintptr_t)(memory + current + FREE_OVERHEAD);
+        uintptr_t end = (uintptr_t)(memory + current + spaceWords(current) - 1);
+        begin = (begin + pageSize - 1) & ~(pageSize - 1);
+        end &= ~(pageSize - 1);
+        if(begin < end)
+        {
+            madvise((void*)begin, end - begin, MADV_DONTNEED);
+        }
+    }
+}
+
+/********************************************************************************
+*   Function:   stats                                                           *
+*   Parameters: None                                                            *
+*   Return Value: Stats                                                         *
+*   Description: returns the heap statistics. Everything but the largest free   *
+*                space is a running counter. The largest free space is exact    *
+*                under every policy and is found without walking memory:        *
+*                BEST_FIT reads it off the right side of its tree in O(log n)   *
+*                steps, SEGREGATED_FIT walks only the highest non-empty bin,    *
+*                which holds it, and the single-list policies walk their one    *
+*                list, as their searches do.                                    *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Stats BasicBoundaryTag<CapacityBytes, TagWord, Policy>::stats()
+{
+    Stats result = counters;
+    result.bytesFree = SIZE * BYTES_PER_WORD - counters.bytesInUse;
+
+    Word largest = 0;
+    if constexpr(placement == BEST_FIT)
+    {
+        for(Word current = treeRoot; current != -1; current = memory[current + 2])
+        {
+            largest = spaceWords(current);
+        }
+    }
+    else if(binMap != 0)
+    {
+        int bin = placement == SEGREGATED_FIT ? std::bit_width(binMap) - 1 : 0;
+        for(Word current = freeBins[bin]; current != -1; current = memory[current + 2])
+        {
+            largest = std::max(largest, spaceWords(current));
+        }
+    }
+    result.largestFreeBlock = largest * BYTES_PER_WORD;
+    return result;
+}
+
+/********************************************************************************
+*   Function:   validate                                                        *
+*   Parameters: None                                                            *
+*   Return Value: bool                                                          *
+*   Description: walks all of memory and every free space structure and         *
+*                returns false, after reporting the first problem found, if:    *
+*                - a space's tags disagree or its size runs off the end of      *
+*                  memory,                                                      *
+*                - two free spaces sit next to each other,                      *
+*                - a free space pointer is not mirrored by the space it points  *
+*                  to, or leads to an allocated space, the wrong bin or out of  *
+*                  order,                                                       *
+*                - the spaces found, or the largest of them, do not match the   *
+*                  statistics, or                                               *
+*                - with HEAP_CHECKS, an allocated space fails blockProblem.     *
+*                Parked blocks are coalesced first. Runs in time linear in the  *
+*                size of memory.                                                *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::validate()
+{
+    if(numParked > 0)
+    {
+        coalesceParked();
+    }
+
+    Word numFree = 0;
+    Word largestFree = 0;
+    size_t bytesInUse = 0;
+    bool previousIsFree = false;
+    for(Word index = 0; index < SIZE; index += spaceWords(index))
+    {
+        Word numWords = spaceWords(index);
+        if(numWords < FREE_OVERHEAD || index + numWords > SIZE)
+        {
+            return invalid("space size out of range", index);
+        }
+        if(memory[index + numWords - 1] != memory[index])
+        {
+            return invalid("boundary tags disagree", index);
+        }
+        if(spaceIsFree(index))
+        {
+            if(previousIsFree)
+            {
+                return invalid("free space not coalesced with the one before it", index);
+            }
+            numFree++;
+            largestFree = std::max(largestFree, numWords);
+        }
+        else
+        {
+            bytesInUse += numWords * BYTES_PER_WORD;
+            if constexpr(HEAP_CHECKS)
+            {
+                const char *problem = blockProblem(index);
+                if(problem != nullptr)
+                {
+                    return invalid(problem, index);
+                }
+            }
+        }
+        previousIsFree = spaceIsFree(index);
+    }
+    if(bytesInUse != counters.bytesInUse || (size_t)numFree != counters.numFreeBlocks)
+    {
+        return invalid("statistics do not match memory", -1);
+    }
+
+    Word numLinked = 0;
+    if constexpr(placement == BEST_FIT)
+    {
+        if(!treeValid(treeRoot, numLinked))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        for(int bin = 0; bin < NUM_BINS; bin++)
+        {
+            Word previousIndex = -1;
+            for(Word current = freeBins[bin]; current != -1; current = memory[current + 2])
+            {
+                if(current < 0 || current >= SIZE || !spaceIsFree(current) || ++numLinked > numFree)
+                {
+                    return invalid("free list leads to a space that is not free", current);
+                }
+                if(memory[current + 1] != previousIndex)
+                {
+                    return invalid("free list pointers do not match", current);
+                }
+                if(placement == SEGREGATED_FIT ? binIndex(spaceWords(current)) != bin : bin != 0)
+                {
+                    return invalid("free space in the wrong bin", current);
+                }
+                if(placement == ADDRESS_ORDERED && current < previousIndex)
+                {
+                    return invalid("free list out of address order", current);
+                }
+                previousIndex = current;
+            }
+            if((freeBins[bin] != -1) != ((binMap >> bin) & 1))
+            {
+                return invalid("binMap does not match the bins", -1);
+            }
+        }
+    }
+    if(numLinked != numFree)
+    {
+        return invalid("free space missing from the free space structure", -1);
+    }
+    //stats() finds the largest free space through the free space structure, so it is only asked once that is sound.
+    if((size_t)largestFree * BYTES_PER_WORD != stats().largestFreeBlock)
+    {
+        return invalid("largest free space does not match the statistics", -1);
+    }
+    return true;
+}
+
+/********************************************************************************
+*   Function:   treeValid                                                       *
+*   Parameters: Word root, Word &count                                          *
+*   Return Value: bool                                                          *
+*   Description: checks that every space in the tree under root is free and     *
+*                ordered against its children and that no parent's priority is  *
+*                lower than a child's, adding the number of spaces to count.    *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::treeValid(Word root, Word &count)
+{
+    if(root == -1)
+    {
+        return true;
+    }
+    if(root < 0 || root >= SIZE || !spaceIsFree(root) || (size_t)++count > counters.numFreeBlocks)
+    {
+        return invalid("free space tree leads to a space that is not free", root);
+    }
+    Word left = memory[root + 1];
+    Word right = memory[root + 2];
+    if((left != -1 && (!treeLess(left, root) || treePriority(left) > treePriority(root))) ||
+       (right != -1 && (!treeLess(root, right) || treePriority(right) > treePriority(root))))
+    {
+        return invalid("free space tree out of order", root);
+    }
+    return treeValid(left, count) && treeValid(right, count);
+}
+
+/********************************************************************************
+*   Function:   invalid                                                         *
+*   Parameters: const char *problem, Word index                                 *
+*   Return Value: bool                                                          *
+*   Description: reports a problem validate found at index (or with the heap as *
+*                a whole when index is -1) and returns false.                   *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+bool BasicBoundaryTag<CapacityBytes, TagWord, Policy>::invalid(const char *problem, Word index)
+{
+    std::cerr << "BoundaryTag::validate: " << problem;
+    if(index != -1)
+    {
+        std::cerr << " at index " << index;
+    }
+    std::cerr << std::endl;
+    return false;
+}
+
+/********************************************************************************
+*   Function:   usableSize                                                      *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: size_t                                                        *
+*   Description: returns how many bytes the caller may use at ptrToMem: every   *
+*                word between the header and trailer, or with HEAP_CHECKS just  *
+*                the bytes asked for, since the rest is canary.                 *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+size_t BasicBoundaryTag<CapacityBytes, TagWord, Policy>::usableSize(void *ptrToMem)
+{
+    Word index = blockIndex(ptrToMem);
+    if constexpr(HEAP_CHECKS)
+    {
+        return memory[index + 1] & ~MAGIC_MASK;
+    }
+    return (spaceWords(index) - HEADER_WORDS - TRAILER_WORDS) * BYTES_PER_WORD;
+}
+
+/********************************************************************************
+*   Function:   size                                                            *
+*   Parameters: void *ptr                                                       *
+*   Retun Value: size_t                                                         *
+*   Description: returns the size in bytes of the given pointer in memory.      *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+size_t BasicBoundaryTag<CapacityBytes, TagWord, Policy>::size(void *ptr)
+{
+    Word *pointerIndex = (Word*)ptr;
+    Word index = pointerIndex - memory;
+    
+    return memory[index] & ~FREE_BIT;
+}
+
+/********************************************************************************
+*   Function:   internalSize                                                    *
+*   Parameters: void *ptr                                                       *
+*   Retun Value: Word                                                           *
+*   Description: returns the size of the given pointer in memory. These pointers*
+*                refer to the location of the left boundary tag and indicate    *
+*                the available number of index spaces wihtin memory.            *
+********************************************************************************/
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+typename BasicBoundaryTag<CapacityBytes, TagWord, Policy>::Word BasicBoundaryTag<CapacityBytes, TagWord, Policy>::internalSize(void *ptrToMem)
+{
+    Word *pointerIndex = (Word*)ptrToMem;
+    Word index = pointerIndex - memory;
+    return spaceWords(index);
+}
+
+template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::SEGREGATED_FIT>;
+template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::FIRST_FIT>;
+template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::NEXT_FIT>;
+template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::ADDRESS_ORDERED>;
+template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::BEST_FIT>;
+template class BasicBoundaryTag<8 * 1024, int32_t, Placement::SEGREGATED_FIT>;
+template class BasicBoundaryTag<16 * 1024 * 1024, int64_t, Placement::SEGREGATED_FIT>;
@@ -1,33 +1,237 @@
-
 #ifndef _BoundaryTag_hpp
 #define _BoundaryTag_hpp
-#define DEBUG false
-#include <math.h>
+// When true, free parks small blocks on quick lists instead of coalescing them straight away. They are coalesced in
+// a batch when too many are parked, when an allocation finds no fit, and before anything looks at the tags.
+#ifndef DEFERRED_COALESCING
+#define DEFERRED_COALESCING false
+#endif
+// When true, every allocated block carries a magic word holding its requested size just after its left tag, and the
+// bytes from the end of the request up to its right tag are filled with a canary. free and reallocate check both and
+// abort on a double free, a bad pointer or a write past the end. When false, blocks have no extra words and nothing
+// is checked.
+#ifndef HEAP_CHECKS
+#define HEAP_CHECKS false
+#endif
+#include "HeapTrace.hpp"
+#include <stdlib.h>
+#include <stdint.h>
 #include <iostream>
+#include <limits>
+#include <type_traits>
 
-class BoundaryTag {
-    enum { SIZE = 4096, BYTES_PER_WORD = sizeof(int), FREE_OVERHEAD = 4 }; 
+// Where allocate places a block. SEGREGATED_FIT keeps free spaces in size-class bins (small bins two words apart,
+// large bins a power of two apart) and uses a bitmap of non-empty bins to find a fitting space. FIRST_FIT keeps them
+// all in one LIFO list and takes the first that fits, and NEXT_FIT does the same but starts each search where the
+// last one stopped. ADDRESS_ORDERED keeps the one list sorted by address. BEST_FIT keeps a tree ordered by size and
+// takes the smallest space that fits. The policy is a template parameter that is only ever tested with if constexpr,
+// so a heap pays nothing for the others, and heaps with different policies can live in the same program.
+enum class Placement { SEGREGATED_FIT, FIRST_FIT, NEXT_FIT, ADDRESS_ORDERED, BEST_FIT };
+
+// The instances of BasicBoundaryTag that BoundaryTag.cpp compiles: every policy for the 32 KiB heap, and
+// SEGREGATED_FIT for the others. The member functions are defined there rather than in this header, so any other
+// instance would compile and then fail to link; BasicBoundaryTag checks against this list to make that a compile
+// error instead. A new instance needs a line here, an extern template at the bottom of this file and an explicit
+// instantiation at the end of BoundaryTag.cpp.
+template <size_t CapacityBytes, class TagWord, Placement Policy>
+constexpr bool isCompiledBoundaryTag = (CapacityBytes == 4096 * sizeof(int64_t) && std::is_same_v<TagWord, int64_t>) ||
+                                       (Policy == Placement::SEGREGATED_FIT &&
+                                        ((CapacityBytes == 8 * 1024 && std::is_same_v<TagWord, int32_t>) ||
+                                         (CapacityBytes == 16 * 1024 * 1024 && std::is_same_v<TagWord, int64_t>)));
+
+// A boundary tag heap of CapacityBytes bytes whose tags, sizes and free space pointers are all TagWords, either
+// int32_t or int64_t, and that places blocks by Policy. All three are known at compile time, so every size and
+// overhead below is a constant. Blocks start on a TagWord boundary. Only the instances in isCompiledBoundaryTag can
+// be used.
+template <size_t CapacityBytes, class TagWord, Placement Policy = Placement::SEGREGATED_FIT>
+class BasicBoundaryTag {
+    static_assert(isCompiledBoundaryTag<CapacityBytes, TagWord, Policy>,
+                  "BoundaryTag.cpp does not instantiate this CapacityBytes, TagWord and Policy; see isCompiledBoundaryTag");
+    static_assert(std::is_same_v<TagWord, int32_t> || std::is_same_v<TagWord, int64_t>, "TagWord must be int32_t or int64_t");
+    static_assert(CapacityBytes % sizeof(TagWord) == 0 && CapacityBytes <= (size_t)std::numeric_limits<TagWord>::max(),
+                  "CapacityBytes must be a whole number of words, and every tag must fit in a TagWord");
 public:
-    BoundaryTag();
-    void* allocate(int numBytes); // allocate a block of memory with "numBytes" bytes
+    typedef TagWord Word;         // boundary tags, sizes and free space pointers are all stored as Words.
+    static constexpr size_t CAPACITY = CapacityBytes; // bytes of memory, tags included.
+    // Words of every allocated block in front of and behind the caller's bytes.
+    enum { HEADER_WORDS = HEAP_CHECKS ? 2 : 1, TRAILER_WORDS = HEAP_CHECKS ? 2 : 1 };
+    static constexpr size_t BLOCK_OVERHEAD = (HEADER_WORDS + TRAILER_WORDS) * sizeof(Word); // bytes added to every block.
+private:
+    enum { SIZE = CapacityBytes / sizeof(Word), BYTES_PER_WORD = sizeof(Word), WORD_SHIFT = sizeof(Word) == 8 ? 3 : 2,
+           FREE_OVERHEAD = 4, NUM_BINS = 64, SMALL_BIN_LIMIT = 64 };
+    // A boundary tag holds the size of its space in bytes. That is always a multiple of BYTES_PER_WORD, so the low
+    // bit is free to mark whether the space is free.
+    enum { FREE_BIT = 1 };
+    // Blocks of fewer than QUICK_LIMIT words are parked when DEFERRED_COALESCING is on, at most MAX_PARKED at a time.
+    enum { QUICK_LIMIT = SMALL_BIN_LIMIT, MAX_PARKED = 64 };
+    // With HEAP_CHECKS, the top bits of the magic word are CHECK_MAGIC and the rest the requested size.
+    enum { CANARY_BYTE = 0xFD, MAGIC_SHIFT = sizeof(Word) == 8 ? 40 : 20 };
+    static constexpr Word CHECK_MAGIC = (Word)(sizeof(Word) == 8 ? 0x5AFEC0ULL << MAGIC_SHIFT : 0x5AFULL << MAGIC_SHIFT);
+    static constexpr Word MAGIC_MASK = ~(((Word)1 << MAGIC_SHIFT) - 1);
+    static_assert(1 << WORD_SHIFT == BYTES_PER_WORD, "WORD_SHIFT must match the size of a Word");
+    static_assert(!HEAP_CHECKS || CapacityBytes < (size_t)1 << MAGIC_SHIFT, "requested sizes must fit below CHECK_MAGIC");
+public:
+    // Every space holds at least FREE_OVERHEAD words, so memory never has more spaces than this.
+    enum { MAX_SPACES = SIZE / FREE_OVERHEAD };
+    using enum Placement;          // so the policies can be named without Placement:: inside the class.
+    static constexpr Placement placement = Policy;
+
+    // Heap statistics, kept up to date by allocate, free and the coalesce functions so they can be read without
+    // walking memory. Sizes are in bytes and include the boundary tags. freeHistogram counts the free spaces in each
+    // bin: bin i holds spaces of 2i and 2i + 1 words below SMALL_BIN_LIMIT words, and bin SMALL_BIN_LIMIT / 2 + k
+    // holds spaces of SMALL_BIN_LIMIT * 2^k up to twice that. largestFreeBlock is the size of the largest free space,
+    // found by stats() from the free space structure rather than kept as a counter.
+    struct Stats {
+        size_t bytesInUse;
+        size_t bytesFree;
+        size_t numFreeBlocks;
+        size_t largestFreeBlock;
+        size_t freeHistogram[NUM_BINS];
+        size_t numAllocates;
+        size_t numFrees;
+        size_t numCoalesces;
+    };
+
+    // A space of memory as an Iterator sees it: the address of its left boundary tag (as next() returns), its size in
+    // bytes including the tags, and whether it is free.
+    struct Space {
+        void *address;
+        size_t bytes;
+        bool free;
+    };
+    // Walks memory one space at a time. An iterator is only an index, so any number of them can be in use at once,
+    // and allocate and free can run in between steps. Changes behind the iterator are not seen. If the space it is on
+    // is coalesced into the one before it, the iterator stops there.
+    class Iterator {
+    public:
+        Iterator(const BasicBoundaryTag *heap, Word index): heap(heap), index(index) {}
+        Space operator*() const
+        {
+            Word tag = heap->memory[index];
+            return {(void*)&heap->memory[index], (size_t)(tag & ~(Word)FREE_BIT), (tag & FREE_BIT) != 0};
+        }
+        Iterator& operator++()
+        {
+            index += heap->memory[index] >> WORD_SHIFT;
+            if(index >= SIZE || heap->memory[index] <= 0)
+            {
+                index = SIZE;
+            }
+            return *this;
+        }
+        bool operator==(const Iterator &other) const { return index == other.index; }
+        bool operator!=(const Iterator &other) const { return index != other.index; }
+    private:
+        const BasicBoundaryTag *heap;
+        Word index;
+    };
+    // What spaces() returns, so that the spaces of memory can be walked with a range-based for loop.
+    struct Spaces {
+        const BasicBoundaryTag *heap;
+        Iterator begin() const { return Iterator(heap, 0); }
+        Iterator end() const { return Iterator(heap, SIZE); }
+    };
+    // Every space of memory at one moment, with one array per field, so a scan of one field reads only that field.
+    struct Snapshot {
+        size_t numSpaces;
+        uint32_t index[MAX_SPACES];             // word index of the space's left boundary tag.
+        uint32_t numWords[MAX_SPACES];          // size of the space in words, tags included.
+        uint64_t freeMap[(MAX_SPACES + 63) / 64]; // bit i is set when space i is free.
+        bool isFree(size_t i) const { return freeMap[i / 64] >> (i % 64) & 1; }
+    };
+
+    BasicBoundaryTag();
+    void* allocate(size_t numBytes); // allocate a block of memory with "numBytes" bytes
+    void* allocate_aligned(size_t numBytes, size_t alignment); // allocate "numBytes" bytes starting at a multiple of "alignment"
+    void* reallocate(void *ptrToMem, size_t numBytes); // resize a block, in place when the space to its right allows it
+    bool resizeInPlace(void *ptrToMem, size_t numBytes); // resize a block without moving it, false if it cannot
+    void* callocate(size_t numElements, size_t elementBytes); // allocate a zeroed array of "numElements" elements
     void free(void *ptrToMem);    // recycle the memory that "ptrToMem" points to.
-    void start();               
+    size_t allocate_batch(size_t numBytes, size_t count, void *out[]); // allocate up to "count" blocks into "out"
+    void free_batch(void *ptrs[], size_t count); // free "count" blocks, sorting "ptrs" by address.
+    void start();
     void* next();
+    Spaces spaces();              // the spaces of memory, for a range-based for loop.
+    void snapshot(Snapshot &out); // copy the address, size and free bit of every space into "out".
     bool isFree(void *ptrToMem);
-    int size(void *ptr); 
+    size_t size(void *ptr);
+    size_t usableSize(void *ptrToMem); // number of bytes the caller may use at "ptrToMem".
+    bool isEmpty();               // true when all of memory is a single free space.
+    void trim();                  // return the pages inside free spaces to the OS.
+    Stats stats();
+    bool validate();              // check every tag and free space pointer, reporting the first problem found.
 
 private:
-    int memory[SIZE];
-    int freeIdx;
-    int iterIdx;
+    Word memory[SIZE];
+    Word freeBins[NUM_BINS];     // index of the first free space in each size class, -1 if the bin is empty. The
+                                 // single-list policies only use freeBins[0].
+    unsigned long long binMap;   // bit i is set when freeBins[i] is not empty.
+    Word rover;                  // NEXT_FIT: the free space the next search starts from.
+    Word treeRoot;               // BEST_FIT: the root of the tree of free spaces, -1 if there are none.
+    Word quickLists[QUICK_LIMIT]; // parked blocks of each size in words, linked through their first word.
+    int numParked;
+    Word iterIdx;
+    Stats counters;              // bytesFree and largestFreeBlock are worked out by stats() instead.
+    Word freshLimit;             // no block below this index has ever been handed out, so its words are still zero.
 
 
-    void leftCoalesce(int &currentLeftBoundary, int coalesceLeftBoundary);
-    void rightCoalesce(int currentLeftBoundary, int coalesceLeftBoundary);
-    void leftRightCoalesce(int &currentLeftBoundary, int leftCoalesceLeftBoundary, int rightCoalesceLeftBoundary);
-    int internalSize(void *ptrToMem);
-    void* internalNext();
-    void internalStart();
+    void leftCoalesce(Word &currentLeftBoundary, Word coalesceLeftBoundary);
+    void rightCoalesce(Word currentLeftBoundary, Word coalesceLeftBoundary);
+    void shrinkInPlace(Word index, Word newSpace);
+    void release(Word index);
+    Word blockIndex(void *ptrToMem) { return (Word*)ptrToMem - memory - HEADER_WORDS; } // left boundary of a block.
+    void* handOut(Word index, size_t numBytes);
+    void trace(HeapTrace::EventType type, Word index, Word numWords, Word other)
+    {
+        if constexpr(HEAP_TRACE)
+        {
+            if(HeapTrace::VERBOSE || (type != HeapTrace::SPLIT && type != HeapTrace::COALESCE))
+            {
+                HeapTrace::record(type, this, sizeof(Word), index, numWords, other);
+            }
+        }
+    }
+    const char* blockProblem(Word index);
+    void checkFailed(const char *problem, void *ptrToMem);
+    bool invalid(const char *problem, Word index);
+    bool treeValid(Word root, Word &count);
+    void coalesceParked();
+    void* allocateAtEnd(size_t numBytes, Word allocatedSpace, size_t alignment);
+    Word alignedStart(Word index, size_t alignment);
+    void leftRightCoalesce(Word &currentLeftBoundary, Word leftCoalesceLeftBoundary, Word rightCoalesceLeftBoundary);
+    Word spaceWords(Word index) { return memory[index] >> WORD_SHIFT; }    // number of words in the space at "index".
+    bool spaceIsFree(Word index) { return memory[index] & FREE_BIT; }
+    void setTags(Word index, Word numWords, Word freeBit)                  // write both boundary tags of a space.
+    {
+        memory[index] = numWords << WORD_SHIFT | freeBit;
+        memory[index + numWords - 1] = numWords << WORD_SHIFT | freeBit;
+    }
+    int binIndex(Word numWords);
+    void insertFree(Word index);
+    void removeFree(Word index);
+    Word findFit(Word numWords);
+    // BEST_FIT keeps free spaces in a treap ordered by size, then address. A free space's left child is stored where
+    // the list policies keep its previous space and its right child where they keep its next space. Priorities are a
+    // hash of the index, so the tree needs no more room than a list.
+    bool treeLess(Word index, Word otherIndex)
+    {
+        return spaceWords(index) < spaceWords(otherIndex) || (spaceWords(index) == spaceWords(otherIndex) && index < otherIndex);
+    }
+    uint64_t treePriority(Word index) { uint64_t hash = (uint64_t)index * 0x9E3779B97F4A7C15ULL; return hash ^ (hash >> 29); }
+    Word treeInsert(Word root, Word index);
+    Word treeRemove(Word root, Word index);
+    Word treeMerge(Word left, Word right);
+    Word internalSize(void *ptrToMem);
 };
 
+typedef BasicBoundaryTag<4096 * sizeof(int64_t), int64_t> BoundaryTag;  // 32 KiB, the heap the drivers test.
+typedef BasicBoundaryTag<8 * 1024, int32_t> TinyBoundaryTag;           // 8 KiB, small enough for one per coroutine.
+typedef BasicBoundaryTag<16 * 1024 * 1024, int64_t> LargeBoundaryTag;  // 16 MiB, for bulk buffers.
+extern template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::SEGREGATED_FIT>;
+extern template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::FIRST_FIT>;
+extern template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::NEXT_FIT>;
+extern template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::ADDRESS_ORDERED>;
+extern template class BasicBoundaryTag<4096 * sizeof(int64_t), int64_t, Placement::BEST_FIT>;
+extern template class BasicBoundaryTag<8 * 1024, int32_t, Placement::SEGREGATED_FIT>;
+extern template class BasicBoundaryTag<16 * 1024 * 1024, int64_t, Placement::SEGREGATED_FIT>;
+
 #endif
@@ -0,0 +1,304 @@
+// malloc, free and the rest of the C and C++ allocation functions, backed by an ArenaHeap of BoundaryTag arenas.
+// Built as libboundarytag.so, it replaces the system allocator in any dynamically linked program:
+//
+//     LD_PRELOAD=./libboundarytag.so ../Project1/a.out
+//
+// One heap is shared by every thread behind a single lock. The heap is built in static storage on first use and is
+// never destroyed, since programs keep freeing memory after static destructors have run. Nothing here calls the
+// system allocator, so an allocation can never re-enter the heap while the lock is held. Around fork the lock is
+// taken, so the child never inherits a heap that another thread was half way through changing.
+#include "ArenaHeap.hpp"
+#include <new>
+#include <errno.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+
+// malloc has to return memory aligned for any type.
+static const size_t MIN_ALIGNMENT = alignof(max_align_t);
+
+static pthread_mutex_t heapLock = PTHREAD_MUTEX_INITIALIZER;
+alignas(ArenaHeap) static unsigned char heapStorage[sizeof(ArenaHeap)];
+static ArenaHeap *heap = nullptr;
+
+/********************************************************************************
+*   Function:   lockHeap                                                        *
+*   Parameters: None                                                            *
+*   Return Value: ArenaHeap*                                                    *
+*   Description: takes the heap lock and returns the heap, building it the      *
+*                first time.                                                    *
+********************************************************************************/
+static ArenaHeap* lockHeap()
+{
+    pthread_mutex_lock(&heapLock);
+    if(heap == nullptr)
+    {
+        heap = new(heapStorage) ArenaHeap();
+    }
+    return heap;
+}
+
+/********************************************************************************
+*   Function:   unlockHeap                                                      *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: releases the heap lock.                                        *
+********************************************************************************/
+static void unlockHeap()
+{
+    pthread_mutex_unlock(&heapLock);
+}
+
+/********************************************************************************
+*   Function:   beforeFork                                                      *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: takes the heap lock so that no other thread is inside the heap *
+*                when the process is copied. The parent and the child both      *
+*                release it once the fork is done; the child has only the       *
+*                forking thread, which is the one holding it.                   *
+********************************************************************************/
+static void beforeFork()
+{
+    lockHeap();
+}
+
+/********************************************************************************
+*   Function:   registerForkHandlers                                            *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: runs when the library is loaded. pthread_atfork may allocate,  *
+*                so it is called here rather than while the heap lock is held.  *
+********************************************************************************/
+__attribute__((constructor)) static void registerForkHandlers()
+{
+    pthread_atfork(beforeFork, unlockHeap, unlockHeap);
+}
+
+/********************************************************************************
+*   Function:   allocateAligned                                                 *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: allocates numBytes bytes at a multiple of alignment (at least  *
+*                MIN_ALIGNMENT) under the heap lock. Sets errno to ENOMEM and   *
+*                returns nullptr if the heap cannot provide them.               *
+********************************************************************************/
+static void* allocateAligned(size_t numBytes, size_t alignment)
+{
+    if(alignment < MIN_ALIGNMENT)
+    {
+        alignment = MIN_ALIGNMENT;
+    }
+    void *ptrToMem = lockHeap()->allocate_aligned(numBytes, alignment);
+    unlockHeap();
+    if(ptrToMem == nullptr)
+    {
+        errno = ENOMEM;
+    }
+    return ptrToMem;
+}
+
+/********************************************************************************
+*   Function:   newAligned                                                      *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: operator new: allocates, calling the new handler and trying    *
+*                again while there is one, and throws std::bad_alloc once there *
+*                is none.                                                       *
+********************************************************************************/
+static void* newAligned(size_t numBytes, size_t alignment)
+{
+    for(;;)
+    {
+        void *ptrToMem = allocateAligned(numBytes, alignment);
+        if(ptrToMem != nullptr)
+        {
+            return ptrToMem;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if(handler == nullptr)
+        {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+/********************************************************************************
+*   Function:   newAlignedNothrow                                               *
+*   Parameters: size_t numBytes, size_t alignment                               *
+*   Return Value: void*                                                         *
+*   Description: operator new(std::nothrow): as newAligned, but returns nullptr *
+*                where that would throw.                                        *
+********************************************************************************/
+static void* newAlignedNothrow(size_t numBytes, size_t alignment) noexcept
+{
+    try
+    {
+        return newAligned(numBytes, alignment);
+    }
+    catch(...)
+    {
+        return nullptr;
+    }
+}
+
+extern "C" {
+
+void* malloc(size_t numBytes) noexcept
+{
+    //Blocks start on a word boundary, so when a word is aligned enough for any type no aligned search is needed.
+    //Otherwise BoundaryTag carves MIN_ALIGNMENT blocks off the end of a free space much as allocate does.
+    if constexpr(sizeof(BoundaryTag::Word) >= MIN_ALIGNMENT)
+    {
+        void *ptrToMem = lockHeap()->allocate(numBytes);
+        unlockHeap();
+        if(ptrToMem == nullptr)
+        {
+            errno = ENOMEM;
+        }
+        return ptrToMem;
+    }
+    return allocateAligned(numBytes, MIN_ALIGNMENT);
+}
+
+void free(void *ptrToMem) noexcept
+{
+    if(ptrToMem == nullptr)
+    {
+        return;
+    }
+    lockHeap()->free(ptrToMem);
+    unlockHeap();
+}
+
+void* calloc(size_t numElements, size_t elementBytes) noexcept
+{
+    if(elementBytes != 0 && numElements > SIZE_MAX / elementBytes)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    void *ptrToMem = malloc(numElements * elementBytes);
+    if(ptrToMem != nullptr)
+    {
+        memset(ptrToMem, 0, numElements * elementBytes);
+    }
+    return ptrToMem;
+}
+
+// The heap resizes the block in place when it can, so only a block that has to move is copied.
+void* realloc(void *ptrToMem, size_t numBytes) noexcept
+{
+    if(ptrToMem == nullptr)
+    {
+        return malloc(numBytes);
+    }
+    if(numBytes == 0)
+    {
+        free(ptrToMem);
+        return nullptr;
+    }
+
+    void *newPtr = lockHeap()->reallocate(ptrToMem, numBytes, MIN_ALIGNMENT);
+    unlockHeap();
+    if(newPtr == nullptr)
+    {
+        errno = ENOMEM;
+    }
+    return newPtr;
+}
+
+void* reallocarray(void *ptrToMem, size_t numElements, size_t elementBytes) noexcept
+{
+    if(elementBytes != 0 && numElements > SIZE_MAX / elementBytes)
+    {
+        errno = ENOMEM;
+        return nullptr;
+    }
+    return realloc(ptrToMem, numElements * elementBytes);
+}
+
+int posix_memalign(void **ptrToPtr, size_t alignment, size_t numBytes) noexcept
+{
+    if(alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+    {
+        return EINVAL;
+    }
+    int savedErrno = errno;
+    void *ptrToMem = allocateAligned(numBytes, alignment);
+    errno = savedErrno;
+    if(ptrToMem == nullptr)
+    {
+        return ENOMEM;
+    }
+    *ptrToPtr = ptrToMem;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t numBytes) noexcept
+{
+    if(alignment == 0 || (alignment & (alignment - 1)) != 0)
+    {
+        errno = EINVAL;
+        return nullptr;
+    }
+    return allocateAligned(numBytes, alignment);
+}
+
+void* memalign(size_t alignment, size_t numBytes) noexcept
+{
+    return aligned_alloc(alignment, numBytes);
+}
+
+void* valloc(size_t numBytes) noexcept
+{
+    return allocateAligned(numBytes, sysconf(_SC_PAGESIZE));
+}
+
+void* pvalloc(size_t numBytes) noexcept
+{
+    size_t pageSize = sysconf(_SC_PAGESIZE);
+    return allocateAligned((numBytes + pageSize - 1) & ~(pageSize - 1), pageSize);
+}
+
+size_t malloc_usable_size(void *ptrToMem) noexcept
+{
+    if(ptrToMem == nullptr)
+    {
+        return 0;
+    }
+    size_t numBytes = lockHeap()->usableSize(ptrToMem);
+    unlockHeap();
+    return numBytes;
+}
+
+}
+
+void* operator new(size_t numBytes) { return newAligned(numBytes, MIN_ALIGNMENT); }
+void* operator new[](size_t numBytes) { return newAligned(numBytes, MIN_ALIGNMENT); }
+void* operator new(size_t numBytes, std::align_val_t alignment) { return newAligned(numBytes, (size_t)alignment); }
+void* operator new[](size_t numBytes, std::align_val_t alignment) { return newAligned(numBytes, (size_t)alignment); }
+void* operator new(size_t numBytes, const std::nothrow_t &) noexcept { return newAlignedNothrow(numBytes, MIN_ALIGNMENT); }
+void* operator new[](size_t numBytes, const std::nothrow_t &) noexcept { return newAlignedNothrow(numBytes, MIN_ALIGNMENT); }
+void* operator new(size_t numBytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return newAlignedNothrow(numBytes, (size_t)alignment);
+}
+void* operator new[](size_t numBytes, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return newAlignedNothrow(numBytes, (size_t)alignment);
+}
+
+void operator delete(void *ptrToMem) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem) noexcept { free(ptrToMem); }
+void operator delete(void *ptrToMem, size_t) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem, size_t) noexcept { free(ptrToMem); }
+void operator delete(void *ptrToMem, std::align_val_t) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem, std::align_val_t) noexcept { free(ptrToMem); }
+void operator delete(void *ptrToMem, size_t, std::align_val_t) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem, size_t, std::align_val_t) noexcept { free(ptrToMem); }
+void operator delete(void *ptrToMem, const std::nothrow_t &) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem, const std::nothrow_t &) noexcept { free(ptrToMem); }
+void operator delete(void *ptrToMem, std::align_val_t, const std::nothrow_t &) noexcept { free(ptrToMem); }
+void operator delete[](void *ptrToMem, std::align_val_t, const std::nothrow_t &) noexcept { free(ptrToMem); }
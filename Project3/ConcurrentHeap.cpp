@@ -0,0 +1,262 @@
+#include "ConcurrentHeap.hpp"
+
+thread_local ConcurrentHeap::ThreadCache ConcurrentHeap::cache;
+std::mutex ConcurrentHeap::ownersMutex;
+
+/********************************************************************************
+*   Function:   ConcurrentHeap                                                  *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: creates an empty heap. Thread caches are set up lazily by the  *
+*                first allocate or free each thread makes.                      *
+********************************************************************************/
+ConcurrentHeap::ConcurrentHeap()
+{
+    caches = nullptr;
+}
+
+/********************************************************************************
+*   Function:   ~ConcurrentHeap                                                 *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: detaches every thread cache still attached to this heap, so    *
+*                that no thread flushes into it after it is gone. The blocks    *
+*                the caches hold are not returned; they go away with the arenas.*
+*                ownersMutex is held throughout, so a thread exiting meanwhile  *
+*                sees either this heap whole or its cache already detached.     *
+********************************************************************************/
+ConcurrentHeap::~ConcurrentHeap()
+{
+    std::lock_guard<std::mutex> ownersLock(ownersMutex);
+    std::lock_guard<std::mutex> lock(mutex);
+    while(caches != nullptr)
+    {
+        ThreadCache *threadCache = caches;
+        caches = threadCache->next;
+        threadCache->owner = nullptr;
+        threadCache->prev = nullptr;
+        threadCache->next = nullptr;
+        for(int sizeClass = 0; sizeClass < NUM_CLASSES; sizeClass++)
+        {
+            threadCache->heads[sizeClass] = nullptr;
+            threadCache->counts[sizeClass] = 0;
+        }
+    }
+}
+
+/********************************************************************************
+*   Function:   allocate                                                        *
+*   Parameters: size_t numBytes                                                 *
+*   Return Value: void*                                                         *
+*   Description: pops a block off the calling thread's cache for the size class *
+*                of numBytes, refilling the cache from the shared heap first if *
+*                it is empty. Blocks too large to cache come straight from the  *
+*                shared heap.                                                   *
+********************************************************************************/
+void* ConcurrentHeap::allocate(size_t numBytes)
+{
+    if(numBytes > MAX_CACHED_BYTES)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return heap.allocate(numBytes);
+    }
+
+    int sizeClass = numBytes == 0 ? 0 : (numBytes - 1) / CLASS_BYTES;
+    ThreadCache &threadCache = this->threadCache();
+    if(threadCache.heads[sizeClass] == nullptr)
+    {
+        refill(threadCache, sizeClass);
+        if(threadCache.heads[sizeClass] == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    void *ptrToMemBlock = threadCache.heads[sizeClass];
+    threadCache.heads[sizeClass] = *(void**)ptrToMemBlock;
+    threadCache.counts[sizeClass]--;
+    return ptrToMemBlock;
+}
+
+/********************************************************************************
+*   Function:   free                                                            *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: None                                                          *
+*   Description: pushes ptrToMem onto the calling thread's cache for the size   *
+*                class it can serve. If that leaves the cache with more than    *
+*                MAX_CACHED blocks, half of them are flushed back to the shared *
+*                heap. Blocks too large to cache go straight back to the heap.  *
+********************************************************************************/
+void ConcurrentHeap::free(void *ptrToMem)
+{
+    if(ptrToMem == nullptr)
+    {
+        return;
+    }
+
+    size_t usableBytes = heap.usableSize(ptrToMem);
+    if(usableBytes >= MAX_CACHED_BYTES + CLASS_BYTES)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        heap.free(ptrToMem);
+        return;
+    }
+
+    //A block can serve any request up to its usable size, so it goes in the largest class it fully covers.
+    int sizeClass = usableBytes / CLASS_BYTES - 1;
+    ThreadCache &threadCache = this->threadCache();
+    *(void**)ptrToMem = threadCache.heads[sizeClass];
+    threadCache.heads[sizeClass] = ptrToMem;
+    if(++threadCache.counts[sizeClass] > MAX_CACHED)
+    {
+        flush(threadCache, sizeClass, MAX_CACHED / 2);
+    }
+}
+
+/********************************************************************************
+*   Function:   threadCache                                                     *
+*   Parameters: None                                                            *
+*   Return Value: ThreadCache&                                                  *
+*   Description: returns the calling thread's cache. A thread has one cache, so *
+*                if it was last used with another heap, its blocks are handed   *
+*                back to that heap first, under ownersMutex so that heap cannot *
+*                be destroyed in between.                                       *
+********************************************************************************/
+ConcurrentHeap::ThreadCache& ConcurrentHeap::threadCache()
+{
+    if(cache.owner.load(std::memory_order_relaxed) != this)
+    {
+        std::lock_guard<std::mutex> ownersLock(ownersMutex);
+        ConcurrentHeap *owner = cache.owner.load(std::memory_order_relaxed);
+        if(owner != nullptr)
+        {
+            owner->detach(cache);
+        }
+        attach(cache);
+    }
+    return cache;
+}
+
+/********************************************************************************
+*   Function:   refill                                                          *
+*   Parameters: ThreadCache &threadCache, int sizeClass                         *
+*   Return Value: None                                                          *
+*   Description: takes the lock once and moves BATCH_SIZE new blocks for        *
+*                sizeClass from the shared heap into threadCache.               *
+********************************************************************************/
+void ConcurrentHeap::refill(ThreadCache &threadCache, int sizeClass)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(int i = 0; i < BATCH_SIZE; i++)
+    {
+        void *ptrToMemBlock = heap.allocate((sizeClass + 1) * CLASS_BYTES);
+        if(ptrToMemBlock == nullptr)
+        {
+            return;
+        }
+        *(void**)ptrToMemBlock = threadCache.heads[sizeClass];
+        threadCache.heads[sizeClass] = ptrToMemBlock;
+        threadCache.counts[sizeClass]++;
+    }
+}
+
+/********************************************************************************
+*   Function:   flush                                                           *
+*   Parameters: ThreadCache &threadCache, int sizeClass, int numBlocks          *
+*   Return Value: None                                                          *
+*   Description: takes the lock once and returns numBlocks blocks of sizeClass  *
+*                from threadCache to the shared heap.                           *
+********************************************************************************/
+void ConcurrentHeap::flush(ThreadCache &threadCache, int sizeClass, int numBlocks)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    returnBlocks(threadCache, sizeClass, numBlocks);
+}
+
+/********************************************************************************
+*   Function:   returnBlocks                                                    *
+*   Parameters: ThreadCache &threadCache, int sizeClass, int numBlocks          *
+*   Return Value: None                                                          *
+*   Description: returns numBlocks blocks of sizeClass from threadCache to the  *
+*                shared heap. The caller holds the lock.                        *
+********************************************************************************/
+void ConcurrentHeap::returnBlocks(ThreadCache &threadCache, int sizeClass, int numBlocks)
+{
+    for(int i = 0; i < numBlocks && threadCache.heads[sizeClass] != nullptr; i++)
+    {
+        void *ptrToMemBlock = threadCache.heads[sizeClass];
+        threadCache.heads[sizeClass] = *(void**)ptrToMemBlock;
+        threadCache.counts[sizeClass]--;
+        heap.free(ptrToMemBlock);
+    }
+}
+
+/********************************************************************************
+*   Function:   attach                                                          *
+*   Parameters: ThreadCache &threadCache                                        *
+*   Return Value: None                                                          *
+*   Description: makes this heap the owner of threadCache, which must not be    *
+*                attached to any heap, and adds it to the list of caches the    *
+*                destructor detaches. The caller holds ownersMutex.             *
+********************************************************************************/
+void ConcurrentHeap::attach(ThreadCache &threadCache)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    threadCache.owner = this;
+    threadCache.prev = nullptr;
+    threadCache.next = caches;
+    if(caches != nullptr)
+    {
+        caches->prev = &threadCache;
+    }
+    caches = &threadCache;
+}
+
+/********************************************************************************
+*   Function:   detach                                                          *
+*   Parameters: ThreadCache &threadCache                                        *
+*   Return Value: None                                                          *
+*   Description: returns every block in threadCache to the shared heap and      *
+*                takes threadCache off this heap's list, leaving it unowned.    *
+*                The caller holds ownersMutex.                                  *
+********************************************************************************/
+void ConcurrentHeap::detach(ThreadCache &threadCache)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for(int sizeClass = 0; sizeClass < NUM_CLASSES; sizeClass++)
+    {
+        returnBlocks(threadCache, sizeClass, threadCache.counts[sizeClass]);
+    }
+    if(threadCache.prev != nullptr)
+    {
+        threadCache.prev->next = threadCache.next;
+    }
+    else
+    {
+        caches = threadCache.next;
+    }
+    if(threadCache.next != nullptr)
+    {
+        threadCache.next->prev = threadCache.prev;
+    }
+    threadCache.owner = nullptr;
+}
+
+/********************************************************************************
+*   Function:   ~ThreadCache                                                    *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: runs when a thread exits and hands its cached blocks back to   *
+*                the heap it was caching for. owner is read under ownersMutex,  *
+*                which that heap's destructor also holds, so the heap is either *
+*                still whole here or has already set owner to nullptr.          *
+********************************************************************************/
+ConcurrentHeap::ThreadCache::~ThreadCache()
+{
+    std::lock_guard<std::mutex> ownersLock(ownersMutex);
+    ConcurrentHeap *heap = owner.load(std::memory_order_relaxed);
+    if(heap != nullptr)
+    {
+        heap->detach(*this);
+    }
+}
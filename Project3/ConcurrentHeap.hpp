@@ -0,0 +1,46 @@
+#ifndef _ConcurrentHeap_hpp
+#define _ConcurrentHeap_hpp
+#include "ArenaHeap.hpp"
+#include <mutex>
+#include <atomic>
+#include <stddef.h>
+
+// A thread-safe heap in the style of tcmalloc. Every thread keeps a small cache of free blocks for each size class,
+// linked through the blocks themselves, so most allocations and frees touch no shared state at all. The shared
+// ArenaHeap behind it is only locked to refill an empty cache, to flush an overfull one, and for blocks too large to
+// cache. A thread returns its cache on exit. A heap that is destroyed first detaches every cache still attached to
+// it, so it may go before the threads that used it, as long as none of them is still calling it. Moving a cache on or
+// off a heap takes one lock shared by all heaps, so an exiting thread never hands its cache to a heap being destroyed.
+class ConcurrentHeap {
+    enum { CLASS_BYTES = 8, NUM_CLASSES = 32, MAX_CACHED_BYTES = CLASS_BYTES * NUM_CLASSES, BATCH_SIZE = 16, MAX_CACHED = 64 };
+public:
+    ConcurrentHeap();
+    ~ConcurrentHeap();
+    void* allocate(size_t numBytes); // allocate a block of memory with "numBytes" bytes
+    void free(void *ptrToMem);       // recycle the memory that "ptrToMem" points to.
+
+private:
+    struct ThreadCache {
+        std::atomic<ConcurrentHeap*> owner; // written only with ownersMutex held.
+        ThreadCache *prev;            // the other caches attached to owner, so the heap can detach them all.
+        ThreadCache *next;
+        void *heads[NUM_CLASSES];     // each free block's first word points to the next block in its class.
+        int counts[NUM_CLASSES];
+        ~ThreadCache();
+    };
+    static thread_local ThreadCache cache;
+    static std::mutex ownersMutex;    // guards the owner of every cache; taken before any heap's mutex.
+
+    ArenaHeap heap;
+    std::mutex mutex;
+    ThreadCache *caches;              // every thread cache attached to this heap, guarded by mutex.
+
+    ThreadCache& threadCache();
+    void refill(ThreadCache &threadCache, int sizeClass);
+    void flush(ThreadCache &threadCache, int sizeClass, int numBlocks);
+    void returnBlocks(ThreadCache &threadCache, int sizeClass, int numBlocks);
+    void attach(ThreadCache &threadCache);
+    void detach(ThreadCache &threadCache);
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "HeapTrace.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string.h>
+
+std::atomic<HeapTrace::Ring*> HeapTrace::rings{nullptr};
+std::atomic<uint32_t> HeapTrace::numThreads{0};
+thread_local HeapTrace::Ring *HeapTrace::threadRing = nullptr;
+
+static pthread_key_t ringKey;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+
+/********************************************************************************
+*   Function:   createRingKey                                                   *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: creates the thread-specific key whose destructor gives a       *
+*                thread's ring back when the thread exits. A thread_local with  *
+*                a destructor would be registered through the heap, which may   *
+*                be the one being traced.                                       *
+********************************************************************************/
+static void createRingKey()
+{
+    pthread_key_create(&ringKey, HeapTrace::detachRing);
+}
+
+/********************************************************************************
+*   Function:   attach                                                          *
+*   Parameters: None                                                            *
+*   Return Value: Ring*                                                         *
+*   Description: gives the calling thread a ring: one left by a thread that has *
+*                exited if there is one, otherwise a newly mapped one. Rings    *
+*                are mapped rather than allocated, since record is called from  *
+*                inside the heaps. Returns nullptr if there is no memory left,  *
+*                in which case the event is not recorded.                       *
+********************************************************************************/
+HeapTrace::Ring* HeapTrace::attach()
+{
+    pthread_once(&ringKeyOnce, createRingKey);
+
+    Ring *ring = rings.load(std::memory_order_acquire);
+    for(; ring != nullptr; ring = ring->next)
+    {
+        bool inUse = false;
+        if(ring->inUse.compare_exchange_strong(inUse, true, std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    if(ring == nullptr)
+    {
+        //Fresh pages are zero, which is a ring with nothing written and every slot empty.
+        void *mapped = mmap(nullptr, sizeof(Ring), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(mapped == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        ring = (Ring*)mapped;
+        ring->inUse.store(true, std::memory_order_relaxed);
+        ring->next = rings.load(std::memory_order_relaxed);
+        while(!rings.compare_exchange_weak(ring->next, ring, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    ring->thread = numThreads.fetch_add(1, std::memory_order_relaxed);
+    threadRing = ring;
+    pthread_setspecific(ringKey, ring);
+    return ring;
+}
+
+/********************************************************************************
+*   Function:   detachRing                                                      *
+*   Parameters: void *ring                                                      *
+*   Return Value: None                                                          *
+*   Description: runs as a thread exits and marks its ring free for the next    *
+*                thread. The events in it stay until that thread overwrites     *
+*                them.                                                          *
+********************************************************************************/
+void HeapTrace::detachRing(void *ring)
+{
+    threadRing = nullptr;
+    ((Ring*)ring)->inUse.store(false, std::memory_order_release);
+}
+
+/********************************************************************************
+*   Function:   snapshot                                                        *
+*   Parameters: Event *events, size_t maxEvents                                 *
+*   Return Value: size_t                                                        *
+*   Description: copies the most recent events of every ring into events,       *
+*                sorted by time, and returns how many were copied. Each ring    *
+*                gets an equal share of maxEvents. A slot that is being written *
+*                while it is copied is skipped.                                 *
+********************************************************************************/
+size_t HeapTrace::snapshot(Event *events, size_t maxEvents)
+{
+    size_t numRings = 0;
+    for(Ring *ring = rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+    {
+        numRings++;
+    }
+    if(numRings == 0 || maxEvents == 0)
+    {
+        return 0;
+    }
+    uint64_t share = std::max<size_t>(maxEvents / numRings, 1);
+
+    size_t numEvents = 0;
+    for(Ring *ring = rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+    {
+        uint64_t last = ring->written.load(std::memory_order_acquire);
+        uint64_t count = std::min({last, share, (uint64_t)CAPACITY});
+        for(uint64_t sequence = last - count + 1; sequence <= last && numEvents < maxEvents; sequence++)
+        {
+            Slot &slot = ring->slots[sequence & (CAPACITY - 1)];
+            if(slot.sequence.load(std::memory_order_acquire) != sequence)
+            {
+                continue;
+            }
+            Event event = slot.event;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(slot.sequence.load(std::memory_order_relaxed) == sequence)
+            {
+                events[numEvents++] = event;
+            }
+        }
+    }
+
+    std::sort(events, events + numEvents, [](const Event &a, const Event &b)
+    {
+        return a.time < b.time || (a.time == b.time && a.thread < b.thread);
+    });
+    return numEvents;
+}
+
+/********************************************************************************
+*   Function:   dump                                                            *
+*   Parameters: const char *path                                                *
+*   Return Value: bool                                                          *
+*   Description: writes a FileHeader and the recorded events to path. Uses a    *
+*                static buffer and plain write calls rather than the heap or    *
+*                iostreams, since it is called when a heap has just been found  *
+*                corrupt. Returns false if the file could not be written.       *
+********************************************************************************/
+bool HeapTrace::dump(const char *path)
+{
+    static Event events[MAX_DUMP_EVENTS];
+    FileHeader header;
+    memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.numEvents = snapshot(events, MAX_DUMP_EVENTS);
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0)
+    {
+        return false;
+    }
+    size_t eventBytes = header.numEvents * sizeof(Event);
+    bool written = write(fd, &header, sizeof(header)) == (ssize_t)sizeof(header) &&
+                   write(fd, events, eventBytes) == (ssize_t)eventBytes;
+    close(fd);
+    return written;
+}
+
+/********************************************************************************
+*   Function:   clear                                                           *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: forgets every recorded event. Must not race with record.       *
+********************************************************************************/
+void HeapTrace::clear()
+{
+    for(Ring *ring = rings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next)
+    {
+        for(Slot &slot : ring->slots)
+        {
+            slot.sequence.store(0, std::memory_order_relaxed);
+        }
+        ring->written.store(0, std::memory_order_release);
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef _HeapTrace_hpp
+#define _HeapTrace_hpp
+// When true, BoundaryTag records every allocate, free and in-place resize in HeapTrace's ring buffers. When 2, it
+// also records every split and coalesce, which doubles the events per allocate/free pair. When false the calls
+// compile away entirely.
+#ifndef HEAP_TRACE
+#define HEAP_TRACE false
+#endif
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Ring buffers of the most recent heap events, one per thread, shared by every heap in the process. Recording an
+// event takes no lock or atomic read-modify-write and never allocates: a thread fills the next slot of its own ring,
+// so threads never write to the same cache line. A thread's ring is mapped the first time it records and is handed
+// to a later thread once it exits. Reading merges the rings by time, and can be done from inside a failing heap.
+class HeapTrace {
+public:
+    enum { CAPACITY = 1 << 14, MAX_DUMP_EVENTS = 1 << 16 }; // CAPACITY events are kept for each thread.
+    enum EventType { ALLOCATE = 1, FREE, SPLIT, COALESCE, RESIZE };
+    static constexpr bool VERBOSE = (int)HEAP_TRACE >= 2;   // record SPLIT and COALESCE as well.
+
+    // index and numWords describe the block or space the event produced, in words. other is the requested bytes for
+    // ALLOCATE, the size of the other piece for SPLIT, the index of the space absorbed for COALESCE and the old size
+    // for RESIZE.
+    struct Event {
+        uint64_t sequence;           // 1 for the first event a ring records, so 0 marks an empty slot.
+        uint64_t time;               // cycles (or nanoseconds where there is no cycle counter).
+        uint64_t heap;               // address of the heap, so the events of several heaps can be told apart.
+        uint32_t index;
+        uint32_t numWords;
+        uint32_t other;
+        uint32_t type;
+        uint32_t thread;             // 0 for the first thread to record, 1 for the next, and so on.
+        uint32_t wordBytes;          // size of the heap's words, which index and numWords are counted in.
+    };
+    // heap.trace files are this header followed by numEvents Events, oldest first.
+    struct FileHeader {
+        char magic[8];
+        uint64_t numEvents;
+    };
+    static constexpr char MAGIC[8] = {'H', 'E', 'A', 'P', 'T', 'R', 'C', '3'};
+
+    static void record(EventType type, const void *heap, size_t wordBytes, int64_t index, int64_t numWords,
+                       int64_t other)
+    {
+        Ring *ring = threadRing != nullptr ? threadRing : attach();
+        if(ring == nullptr)
+        {
+            return;
+        }
+        uint64_t sequence = ring->written.load(std::memory_order_relaxed) + 1;
+        Slot &slot = ring->slots[sequence & (CAPACITY - 1)];
+        // A reader that sees the same sequence before and after copying the event knows it was not half written.
+        slot.sequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = {sequence, now(), (uint64_t)(uintptr_t)heap, (uint32_t)index, (uint32_t)numWords,
+                      (uint32_t)other, (uint32_t)type, ring->thread, (uint32_t)wordBytes};
+        slot.sequence.store(sequence, std::memory_order_release);
+        ring->written.store(sequence, std::memory_order_release);
+    }
+    static size_t snapshot(Event *events, size_t maxEvents);  // copies out the recorded events, oldest first.
+    static bool dump(const char *path);                       // writes them to a trace file.
+    static void clear();
+    static void detachRing(void *ring);                       // gives back a ring as its thread exits.
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        Event event;
+    };
+    struct Ring {
+        std::atomic<uint64_t> written;   // sequence of the last event recorded.
+        std::atomic<bool> inUse;         // false once the thread that owned the ring has exited.
+        uint32_t thread;
+        Ring *next;
+        Slot slots[CAPACITY];
+    };
+    static std::atomic<Ring*> rings;
+    static std::atomic<uint32_t> numThreads;
+    static thread_local Ring *threadRing;
+
+    static Ring* attach();
+
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "Region.hpp"
+
+/********************************************************************************
+*   Function:   Region                                                          *
+*   Parameters: BoundaryTag *heap, size_t numBytes                              *
+*   Return Value: None                                                          *
+*   Description: takes a block of numBytes bytes from heap and starts handing   *
+*                out memory from its beginning. If the heap has no room, the    *
+*                region is empty and every allocate returns nullptr.            *
+********************************************************************************/
+Region::Region(BoundaryTag *heap, size_t numBytes)
+{
+    this->heap = heap;
+    base = (char*)heap->allocate(numBytes);
+    top = base;
+    limit = base == nullptr ? base : base + numBytes;
+}
+
+/********************************************************************************
+*   Function:   ~Region                                                         *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: gives the region's block back to the heap in one free, however *
+*                many allocations were made from it.                            *
+********************************************************************************/
+Region::~Region()
+{
+    if(base != nullptr)
+    {
+        heap->free(base);
+    }
+}
+
+/********************************************************************************
+*   Function:   reset                                                           *
+*   Parameters: None                                                            *
+*   Return Value: None                                                          *
+*   Description: frees everything allocated from the region by moving the       *
+*                pointer back to the start of its block. Runs in constant time  *
+*                and does not touch the heap.                                   *
+********************************************************************************/
+void Region::reset()
+{
+    top = base;
+}
+
+/********************************************************************************
+*   Function:   bytesUsed                                                       *
+*   Parameters: None                                                            *
+*   Return Value: size_t                                                        *
+*   Description: returns the number of bytes allocated since the last reset,    *
+*                including the padding that keeps allocations word aligned.     *
+********************************************************************************/
+size_t Region::bytesUsed()
+{
+    return top - base;
+}
+
+/********************************************************************************
+*   Function:   capacity                                                        *
+*   Parameters: None                                                            *
+*   Return Value: size_t                                                        *
+*   Description: returns the number of bytes the region can hand out between    *
+*                resets.                                                        *
+********************************************************************************/
+size_t Region::capacity()
+{
+    return limit - base;
+}
@@ -0,0 +1,42 @@
+#ifndef _Region_hpp
+#define _Region_hpp
+#include "BoundaryTag.hpp"
+#include <stddef.h>
+
+// A region for allocations that all live exactly as long as one piece of work, such as a request. The region takes a
+// single block from a BoundaryTag heap and hands out memory from it by moving a pointer forward, with no tags or
+// free lists. free is a no-op; reset makes all of the region's memory available again at once, and destroying the
+// region gives its block back to the heap, which rewrites just that one block's pair of boundary tags. The heap must
+// outlive the region.
+class Region {
+    enum { ALIGNMENT = sizeof(BoundaryTag::Word) };
+public:
+    Region(BoundaryTag *heap, size_t numBytes); // take a "numBytes" byte block from "heap" for the region.
+    ~Region();
+    void* allocate(size_t numBytes)             // allocate "numBytes" bytes, or nullptr if the region is full.
+    {
+        size_t roundedBytes = (numBytes + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1);
+        if(roundedBytes < numBytes || roundedBytes > (size_t)(limit - top))
+        {
+            return nullptr;
+        }
+        void *ptrToMem = top;
+        top += roundedBytes;
+        return ptrToMem;
+    }
+    void free(void *) {}                        // region memory is only released all at once.
+    void reset();
+    size_t bytesUsed();
+    size_t capacity();                          // 0 if the heap had no room for the region.
+
+private:
+    BoundaryTag *heap;
+    char *base;
+    char *top;
+    char *limit;
+
+    Region(const Region &) = delete;
+    Region& operator=(const Region &) = delete;
+};
+
+#endif
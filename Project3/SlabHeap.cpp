@@ -0,0 +1,219 @@
+#include "SlabHeap.hpp"
+#include <bit>
+
+/********************************************************************************
+*   Function:   SlabHeap                                                        *
+*   Parameters: BoundaryTag *heap                                               *
+*   Return Value: None                                                          *
+*   Description: starts with no slabs. The page table starts at the page the    *
+*                BoundaryTag heap begins in.                                    *
+********************************************************************************/
+SlabHeap::SlabHeap(BoundaryTag *heap)
+{
+    this->heap = heap;
+    firstPage = (uintptr_t)heap & ~(uintptr_t)(SLAB_BYTES - 1);
+    slabCount = 0;
+    for(int i = 0; i < NUM_PAGES; i++)
+    {
+        pages[i] = nullptr;
+    }
+    for(int i = 0; i < NUM_CLASSES; i++)
+    {
+        partialSlabs[i] = nullptr;
+    }
+}
+
+/********************************************************************************
+*   Function:   allocate                                                        *
+*   Parameters: size_t numBytes                                                 *
+*   Return Value: void*                                                         *
+*   Description: takes the lowest free slot of the first slab with room in the  *
+*                size class of numBytes, carving a new slab out of the          *
+*                BoundaryTag heap if there is none. A slab that becomes full    *
+*                leaves the list of slabs with room. Requests too large for a   *
+*                slab go to the BoundaryTag heap.                               *
+********************************************************************************/
+void* SlabHeap::allocate(size_t numBytes)
+{
+    if(numBytes > MAX_SLAB_BYTES)
+    {
+        return heap->allocate(numBytes);
+    }
+
+    int sizeClass = numBytes <= (1 << MIN_CLASS_SHIFT) ? 0 : std::bit_width(numBytes - 1) - MIN_CLASS_SHIFT;
+    Slab *slab = partialSlabs[sizeClass];
+    if(slab == nullptr)
+    {
+        slab = newSlab(sizeClass);
+        if(slab == nullptr)
+        {
+            return nullptr;
+        }
+    }
+
+    int word = slab->freeMap[0] != 0 ? 0 : 1;
+    int slot = word * 64 + std::countr_zero(slab->freeMap[word]);
+    slab->freeMap[word] &= slab->freeMap[word] - 1;
+    if(--slab->numFree == 0)
+    {
+        unlink(slab);
+    }
+    return (char*)slab + firstSlot(sizeClass) + ((size_t)slot << (sizeClass + MIN_CLASS_SHIFT));
+}
+
+/********************************************************************************
+*   Function:   free                                                            *
+*   Parameters: void *ptrToMem                                                  *
+*   Return Value: None                                                          *
+*   Description: looks up the page ptrToMem is in. If it belongs to a slab, the *
+*                object's slot is marked free in the slab's bitmap and a full   *
+*                slab goes back on the list of slabs with room. A slab that is  *
+*                now empty is handed back to the BoundaryTag heap, unless it is *
+*                the last slab of its class with room. Anything else was a      *
+*                BoundaryTag block and is freed there.                          *
+********************************************************************************/
+void SlabHeap::free(void *ptrToMem)
+{
+    if(ptrToMem == nullptr)
+    {
+        return;
+    }
+
+    uintptr_t page = ((uintptr_t)ptrToMem - firstPage) >> SLAB_SHIFT;
+    Slab *slab = page < NUM_PAGES ? pages[page] : nullptr;
+    if(slab == nullptr)
+    {
+        heap->free(ptrToMem);
+        return;
+    }
+
+    int sizeClass = slab->sizeClass;
+    int slot = ((char*)ptrToMem - (char*)slab - firstSlot(sizeClass)) >> (sizeClass + MIN_CLASS_SHIFT);
+    slab->freeMap[slot / 64] |= 1ULL << (slot % 64);
+
+    if(slab->numFree++ == 0)
+    {
+        slab->prev = nullptr;
+        slab->next = partialSlabs[sizeClass];
+        if(slab->next != nullptr)
+        {
+            slab->next->prev = slab;
+        }
+        partialSlabs[sizeClass] = slab;
+    }
+    else if(slab->numFree == numSlots(sizeClass) && (slab->prev != nullptr || slab->next != nullptr))
+    {
+        releaseSlab(slab);
+    }
+}
+
+/********************************************************************************
+*   Function:   numSlabs                                                        *
+*   Parameters: None                                                            *
+*   Return Value: int                                                           *
+*   Description: returns the number of slabs taken from the BoundaryTag heap.   *
+********************************************************************************/
+int SlabHeap::numSlabs()
+{
+    return slabCount;
+}
+
+/********************************************************************************
+*   Function:   newSlab                                                         *
+*   Parameters: int sizeClass                                                   *
+*   Return Value: Slab*                                                         *
+*   Description: carves a slab for sizeClass out of the BoundaryTag heap at the *
+*                start of a page, marks every slot free, records it in the page *
+*                table and puts it on the list of slabs with room. Returns      *
+*                nullptr if the heap has no room for it.                        *
+********************************************************************************/
+SlabHeap::Slab* SlabHeap::newSlab(int sizeClass)
+{
+    Slab *slab = (Slab*)heap->allocate_aligned(SLAB_USABLE_BYTES, SLAB_BYTES);
+    if(slab == nullptr)
+    {
+        return nullptr;
+    }
+
+    int slots = numSlots(sizeClass);
+    slab->sizeClass = sizeClass;
+    slab->numFree = slots;
+    for(int word = 0; word < MAP_WORDS; word++)
+    {
+        int bits = slots - word * 64;
+        slab->freeMap[word] = bits >= 64 ? ~0ULL : bits <= 0 ? 0 : (1ULL << bits) - 1;
+    }
+
+    slab->prev = nullptr;
+    slab->next = partialSlabs[sizeClass];
+    if(slab->next != nullptr)
+    {
+        slab->next->prev = slab;
+    }
+    partialSlabs[sizeClass] = slab;
+    pages[((uintptr_t)slab - firstPage) >> SLAB_SHIFT] = slab;
+    slabCount++;
+    return slab;
+}
+
+/********************************************************************************
+*   Function:   releaseSlab                                                     *
+*   Parameters: Slab *slab                                                      *
+*   Return Value: None                                                          *
+*   Description: takes an empty slab off its list and out of the page table and *
+*                frees it in the BoundaryTag heap.                              *
+********************************************************************************/
+void SlabHeap::releaseSlab(Slab *slab)
+{
+    unlink(slab);
+    pages[((uintptr_t)slab - firstPage) >> SLAB_SHIFT] = nullptr;
+    slabCount--;
+    heap->free(slab);
+}
+
+/********************************************************************************
+*   Function:   unlink                                                          *
+*   Parameters: Slab *slab                                                      *
+*   Return Value: None                                                          *
+*   Description: removes slab from the list of slabs with room in its class.    *
+********************************************************************************/
+void SlabHeap::unlink(Slab *slab)
+{
+    if(slab->prev == nullptr)
+    {
+        partialSlabs[slab->sizeClass] = slab->next;
+    }
+    else
+    {
+        slab->prev->next = slab->next;
+    }
+    if(slab->next != nullptr)
+    {
+        slab->next->prev = slab->prev;
+    }
+}
+
+/********************************************************************************
+*   Function:   firstSlot                                                       *
+*   Parameters: int sizeClass                                                   *
+*   Return Value: size_t                                                        *
+*   Description: returns how far the first object is from the start of a slab:  *
+*                the size of the header rounded up to the size of an object, so *
+*                every object is aligned to its own size.                       *
+********************************************************************************/
+size_t SlabHeap::firstSlot(int sizeClass)
+{
+    size_t objectBytes = (size_t)1 << (sizeClass + MIN_CLASS_SHIFT);
+    return (sizeof(Slab) + objectBytes - 1) & ~(objectBytes - 1);
+}
+
+/********************************************************************************
+*   Function:   numSlots                                                        *
+*   Parameters: int sizeClass                                                   *
+*   Return Value: int                                                           *
+*   Description: returns how many objects of sizeClass fit in a slab.           *
+********************************************************************************/
+int SlabHeap::numSlots(int sizeClass)
+{
+    return (SLAB_USABLE_BYTES - firstSlot(sizeClass)) >> (sizeClass + MIN_CLASS_SHIFT);
+}
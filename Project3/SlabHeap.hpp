@@ -0,0 +1,50 @@
+#ifndef _SlabHeap_hpp
+#define _SlabHeap_hpp
+#include "BoundaryTag.hpp"
+#include <stddef.h>
+#include <stdint.h>
+
+// A small-object layer in front of a BoundaryTag heap. Requests of up to MAX_SLAB_BYTES bytes are rounded up to a
+// power-of-two size class and served from slabs: SLAB_BYTES-aligned blocks carved out of the BoundaryTag heap, each
+// holding objects of a single class. A bitmap in the slab header tracks the free slots, so objects carry no header or
+// boundary tags of their own and requests too small for a boundary-tag block can still be served. Larger requests go
+// straight to the BoundaryTag heap. The heap must outlive the SlabHeap.
+class SlabHeap {
+    enum { SLAB_BYTES = 1024, SLAB_SHIFT = 10, MIN_CLASS_SHIFT = 3, NUM_CLASSES = 4, MAP_WORDS = 2 };
+    enum { MAX_SLAB_BYTES = 1 << (MIN_CLASS_SHIFT + NUM_CLASSES - 1) };
+    // A slab is a BoundaryTag block whose tags sit just outside its page, so that slabs can fill consecutive pages.
+    enum { SLAB_USABLE_BYTES = SLAB_BYTES - BoundaryTag::BLOCK_OVERHEAD };
+public:
+    SlabHeap(BoundaryTag *heap);
+    void* allocate(size_t numBytes); // allocate a block of memory with "numBytes" bytes
+    void free(void *ptrToMem);       // recycle the memory that "ptrToMem" points to.
+    int numSlabs();
+
+private:
+    // Sits at the start of every slab, with the objects after it.
+    struct Slab {
+        Slab *prev;                  // the slabs of a class with free slots are kept in a list.
+        Slab *next;
+        int sizeClass;
+        int numFree;
+        uint64_t freeMap[MAP_WORDS]; // bit i is set when slot i is free.
+    };
+    static_assert((SLAB_USABLE_BYTES - sizeof(Slab)) >> MIN_CLASS_SHIFT <= MAP_WORDS * 64, "freeMap is too small for the smallest class");
+    // pages has an entry for every SLAB_BYTES-aligned page the BoundaryTag heap overlaps, and each slab fills exactly
+    // one of them, so free can tell a slab object from a BoundaryTag block without a header.
+    enum { NUM_PAGES = sizeof(BoundaryTag) / SLAB_BYTES + 2 };
+
+    BoundaryTag *heap;
+    uintptr_t firstPage;
+    Slab *pages[NUM_PAGES];
+    Slab *partialSlabs[NUM_CLASSES];
+    int slabCount;
+
+    Slab* newSlab(int sizeClass);
+    void releaseSlab(Slab *slab);
+    void unlink(Slab *slab);
+    static size_t firstSlot(int sizeClass);  // offset of the first object from the start of a slab.
+    static int numSlots(int sizeClass);
+};
+
+#endif
@@ -0,0 +1,157 @@
+#include "ArenaHeap.hpp"
+#include "AllocationRecorder.hpp"
+#include<iostream>
+#include<string.h>
+#include<stdlib.h>
+#include<vector>
+#include<stdint.h>
+#include<map>
+
+using namespace std;
+
+const size_t LIVE_BYTES = 256 * 1024 * 1024;
+
+// Set when the driver is given a file name, so its workload can be replayed with benchmark.x --replay.
+AllocationRecorder *recorder = nullptr;
+
+struct Block {
+    unsigned char *ptr;
+    size_t bytes;
+    unsigned char pattern;
+};
+
+// Frees a random block after checking that nothing else wrote over it.
+void freeABlock( ArenaHeap *heap, vector<Block> &blocks, size_t &liveBytes )
+{
+    int idx = rand() % blocks.size();
+    Block b = blocks[ idx ];
+    for( size_t i = 0; i < b.bytes; i++ )
+        if( b.ptr[ i ] != b.pattern ) {
+            std::cout << "Block at " << (void*)b.ptr << " was overwritten\n";
+            exit( 1 );
+        }
+    if( recorder )
+        recorder->freed( b.ptr );
+    heap->free( b.ptr );
+    liveBytes -= b.bytes;
+    blocks[ idx ] = blocks.back();
+    blocks.pop_back();
+}
+
+int main( int argc, char *argv[] )
+{
+    ArenaHeap *heap = new ArenaHeap();
+    srand( 13 );
+    if( argc > 1 ) {
+        recorder = new AllocationRecorder( argv[ 1 ] );
+        if( ! recorder->isOpen() ) {
+            std::cout << "Cannot write " << argv[ 1 ] << "\n";
+            exit( 1 );
+        }
+    }
+
+    vector<Block> blocks;
+    size_t liveBytes = 0;
+
+    // Grow the live set far past the size of a single arena, with some churn along the way.
+    while( liveBytes < LIVE_BYTES ) {
+        if( rand() % 100 < 70 || blocks.empty() ) {
+            size_t n = rand() % 100 == 0 ? rand() % 65536 + 4097 : rand() % 150 + 1;
+            unsigned char *ptr = (unsigned char*)heap->allocate( n );
+            if( ptr == 0 ) {
+                std::cout << "Ran out of memory with " << liveBytes << " bytes live\n";
+                exit( 1 );
+            }
+            if( recorder )
+                recorder->allocated( ptr, n );
+            unsigned char pattern = rand();
+            memset( ptr, pattern, n );
+            blocks.push_back( { ptr, n, pattern } );
+            liveBytes += n;
+        } else
+            freeABlock( heap, blocks, liveBytes );
+    }
+
+    std::cout << "Holding " << liveBytes << " bytes in " << heap->numArenas() << " arenas, "
+              << heap->mappedBytes() << " bytes mapped.\n";
+
+    while( ! blocks.empty() )
+        freeABlock( heap, blocks, liveBytes );
+
+    // Aligned blocks, including alignments at and past the arena alignment, must come back aligned and free cleanly.
+    for( size_t alignment = 16; alignment <= 4 * 1024 * 1024; alignment *= 2 )
+        for( size_t n : { 100, 5000, 200000 } ) {
+            unsigned char *ptr = (unsigned char*)heap->allocate_aligned( n, alignment );
+            if( ptr == 0 || (uintptr_t)ptr % alignment != 0 || heap->usableSize( ptr ) < n ) {
+                std::cout << "Bad " << n << " byte block aligned to " << alignment << "\n";
+                exit( 3 );
+            }
+            memset( ptr, 0x5a, n );
+            heap->free( ptr );
+        }
+
+    // Grow one block from a few bytes to several arenas' worth and shrink it back, checking its contents each time.
+    unsigned char *ptr = 0;
+    size_t n = 0;
+    for( size_t next : { 10, 40, 300, 3000, 5000, 70000, 1000000, 4000000, 100000, 2000, 20 } ) {
+        ptr = (unsigned char*)heap->reallocate( ptr, next );
+        if( ptr == 0 ) {
+            std::cout << "Could not resize a block to " << next << " bytes\n";
+            exit( 3 );
+        }
+        for( size_t i = 0; i < n && i < next; i++ )
+            if( ptr[ i ] != (unsigned char)i ) {
+                std::cout << "Resizing to " << next << " bytes lost the contents\n";
+                exit( 3 );
+            }
+        for( size_t i = 0; i < next; i++ )
+            ptr[ i ] = (unsigned char)i;
+        n = next;
+    }
+    heap->free( ptr );
+
+    // Fill five arenas and start a sixth, then empty one full arena so it becomes the spare and free a block in each of
+    // the other four, which moves them in front of it. A request none of those four can hold must reuse the spare
+    // rather than map a seventh arena. Arenas are mapped at multiples of 64 KiB, which groups the blocks by arena.
+    map<uintptr_t, vector<void*>> byArena;
+    void *last;
+    do {
+        last = heap->allocate( 64 );
+        byArena[ ( (uintptr_t)last - 1 ) & ~(uintptr_t)0xffff ].push_back( last );
+    } while( heap->numArenas() < 6 );
+    bool spareMade = false;
+    for( auto &arena : byArena ) {
+        if( arena.first == ( ( (uintptr_t)last - 1 ) & ~(uintptr_t)0xffff ) )
+            continue;
+        if( ! spareMade ) {
+            spareMade = true;
+            while( ! arena.second.empty() ) {
+                heap->free( arena.second.back() );
+                arena.second.pop_back();
+            }
+        } else {
+            heap->free( arena.second.back() );
+            arena.second.pop_back();
+        }
+    }
+    ptr = (unsigned char*)heap->allocate( 4000 );
+    if( ptr == 0 || heap->numArenas() != 6 ) {
+        std::cout << "Mapped a new arena while the spare was empty: " << heap->numArenas() << " arenas\n";
+        exit( 2 );
+    }
+    heap->free( ptr );
+    for( auto &arena : byArena )
+        for( void *block : arena.second )
+            heap->free( block );
+
+    std::cout << "After freeing everything: " << heap->numArenas() << " arenas, "
+              << heap->mappedBytes() << " bytes mapped.\n";
+    if( heap->numArenas() > 1 ) {
+        std::cout << "Empty arenas were not returned to the OS!\n";
+        exit( 2 );
+    }
+
+    delete recorder;
+    delete heap;
+    return 0;
+}
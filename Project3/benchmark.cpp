@@ -0,0 +1,409 @@
+#include "ArenaHeap.hpp"
+#include "AllocationRecorder.hpp"
+#include<iostream>
+#include<iomanip>
+#include<string>
+#include<cmath>
+#include<string.h>
+#include<fstream>
+#include<stdlib.h>
+#include<vector>
+#include<deque>
+#include<algorithm>
+#include<chrono>
+#include<random>
+#include<malloc.h>
+#include<sys/mman.h>
+
+using namespace std;
+
+// The benchmark's own bookkeeping is kept in memory mapped straight from the OS, so that it neither uses nor
+// fragments the malloc heap being measured.
+template <class T>
+struct MappedAllocator {
+  typedef T value_type;
+  MappedAllocator() {}
+  template <class U> MappedAllocator( const MappedAllocator<U> & ) {}
+  T* allocate( size_t n ) {
+    void *ptr = mmap( 0, n * sizeof( T ), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if( ptr == MAP_FAILED )
+      throw std::bad_alloc();
+    return (T*)ptr;
+  }
+  void deallocate( T *ptr, size_t n ) { munmap( ptr, n * sizeof( T ) ); }
+  template <class U> bool operator==( const MappedAllocator<U> & ) const { return true; }
+  template <class U> bool operator!=( const MappedAllocator<U> & ) const { return false; }
+};
+
+template <class T> using Vector = vector<T, MappedAllocator<T>>;
+
+// One step of a trace: allocate "size" bytes into slot "id", or free the block in slot "id".
+struct Op {
+  bool allocate;
+  size_t size;
+  int id;
+};
+
+struct Trace {
+  string name;
+  Vector<Op> ops;
+  int numSlots;
+};
+
+struct Result {
+  double opsPerSecond;
+  double p50, p99;          // nanoseconds per operation
+  size_t peakFootprint;     // bytes the allocator held from the OS at its peak
+  size_t liveAtPeak;        // bytes the trace had allocated at that moment
+};
+
+/********************************************************************************
+*   Allocators. Each one offers allocate, free and footprint, which is the      *
+*   number of bytes it currently holds from the OS. The constructor is given    *
+*   the total number of bytes the trace allocates, which only bump needs.       *
+********************************************************************************/
+class BoundaryTagAllocator {
+public:
+  BoundaryTagAllocator( size_t ) {}
+  void* allocate( size_t n ) { return heap.allocate( n ); }
+  void free( void *ptr ) { heap.free( ptr ); }
+  size_t footprint() { return heap.mappedBytes(); }
+
+private:
+  ArenaHeap heap;
+};
+
+// glibc reports the whole heap, so the bytes that were already in use when the allocator was created (iostream
+// buffers and the like) are subtracted. Free space the heap already had is counted, as the trace can use it. glibc
+// grows its heap with a 128 KiB pad and only trims it once the top 128 KiB are free, so for a small peak this footprint
+// is mostly that granularity rather than fragmentation; main prints that caveat under the table.
+class MallocAllocator {
+public:
+  MallocAllocator( size_t ) {
+    malloc_trim( 0 );
+    struct mallinfo2 info = mallinfo2();
+    baseInUse = info.uordblks + info.hblkhd;
+  }
+  void* allocate( size_t n ) { return malloc( n ); }
+  void free( void *ptr ) { ::free( ptr ); }
+  size_t footprint() { struct mallinfo2 info = mallinfo2(); return info.arena + info.hblkhd - baseInUse; }
+
+private:
+  size_t baseInUse;
+};
+
+// Hands out memory by moving a pointer forward and never reuses it, which is the lower bound on allocation cost. The
+// mapping is populated when it is made, so the page faults of first touching it are not counted as allocation cost.
+class BumpAllocator {
+public:
+  BumpAllocator( size_t capacity ): capacity( capacity ), used( 0 ) {
+    base = (char*)mmap( 0, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0 );
+    if( base == MAP_FAILED ) {
+      std::cout << "Cannot map " << capacity << " bytes for the bump allocator\n";
+      exit( 1 );
+    }
+  }
+  ~BumpAllocator() { munmap( base, capacity ); }
+  void* allocate( size_t n ) {
+    n = ( n + 15 ) & ~(size_t)15;
+    if( used + n > capacity )
+      return 0;
+    void *ptr = base + used;
+    used += n;
+    return ptr;
+  }
+  void free( void * ) {}
+  size_t footprint() { return used; }
+
+private:
+  char *base;
+  size_t capacity, used;
+};
+
+/********************************************************************************
+*   Traces. Every trace keeps at most maxLive blocks allocated and frees        *
+*   everything that is still live at the end.                                   *
+********************************************************************************/
+size_t powerLawSize( std::mt19937 &random )
+{
+  // Pareto distributed with alpha = 1.2: mostly small blocks with a long tail of large ones.
+  double u = std::uniform_real_distribution<double>( 0.0, 1.0 )( random );
+  double size = 16.0 / pow( 1.0 - u, 1.0 / 1.2 );
+  return size > 65536 ? 65536 : (size_t)size;
+}
+
+// Allocates or frees a random live block with equal probability.
+Trace randomTrace( string name, int numOps, int maxLive, bool powerLaw, int seed )
+{
+  std::mt19937 random( seed );
+  Trace trace{ name, {}, 0 };
+  Vector<int> live, freeSlots;
+
+  for( int i = 0; i < numOps; i++ ) {
+    if( live.empty() || ( (int)live.size() < maxLive && random() % 2 == 0 ) ) {
+      size_t size = powerLaw ? powerLawSize( random ) : random() % 512 + 1;
+      int id = freeSlots.empty() ? trace.numSlots++ : freeSlots.back();
+      if( ! freeSlots.empty() )
+        freeSlots.pop_back();
+      trace.ops.push_back( { true, size, id } );
+      live.push_back( id );
+    } else {
+      int idx = random() % live.size();
+      trace.ops.push_back( { false, 0, live[ idx ] } );
+      freeSlots.push_back( live[ idx ] );
+      live[ idx ] = live.back();
+      live.pop_back();
+    }
+  }
+  for( int id : live )
+    trace.ops.push_back( { false, 0, id } );
+  return trace;
+}
+
+// A producer allocates messages in bursts and a consumer frees them oldest first.
+Trace producerConsumerTrace( int numOps, int maxLive, int seed )
+{
+  std::mt19937 random( seed );
+  Trace trace{ "producer/consumer", {}, 0 };
+  deque<int, MappedAllocator<int>> queue;
+  Vector<int> freeSlots;
+
+  while( (int)trace.ops.size() < numOps ) {
+    int burst = random() % 64 + 1;
+    for( int i = 0; i < burst && (int)queue.size() < maxLive; i++ ) {
+      int id = freeSlots.empty() ? trace.numSlots++ : freeSlots.back();
+      if( ! freeSlots.empty() )
+        freeSlots.pop_back();
+      trace.ops.push_back( { true, random() % 1024 + 16, id } );
+      queue.push_back( id );
+    }
+    int consumed = random() % 64 + 1;
+    for( int i = 0; i < consumed && ! queue.empty(); i++ ) {
+      trace.ops.push_back( { false, 0, queue.front() } );
+      freeSlots.push_back( queue.front() );
+      queue.pop_front();
+    }
+  }
+  for( int id : queue )
+    trace.ops.push_back( { false, 0, id } );
+  return trace;
+}
+
+// Blocks are freed in the reverse order they were allocated, like a call stack.
+Trace lifoTrace( int numOps, int maxLive, int seed )
+{
+  std::mt19937 random( seed );
+  Trace trace{ "lifo", {}, 0 };
+  Vector<int> stack;
+
+  for( int i = 0; i < numOps; i++ ) {
+    if( stack.empty() || ( (int)stack.size() < maxLive && random() % 2 == 0 ) ) {
+      int id = stack.size();
+      trace.numSlots = std::max( trace.numSlots, id + 1 );
+      trace.ops.push_back( { true, random() % 256 + 1, id } );
+      stack.push_back( id );
+    } else {
+      trace.ops.push_back( { false, 0, stack.back() } );
+      stack.pop_back();
+    }
+  }
+  while( ! stack.empty() ) {
+    trace.ops.push_back( { false, 0, stack.back() } );
+    stack.pop_back();
+  }
+  return trace;
+}
+
+// A trace written by AllocationRecorder. The blocks still live at the end of the recording are freed at the end of
+// the replay, as in the other traces.
+Trace recordedTrace( const char *path )
+{
+  ifstream in( path, ios::binary );
+  AllocationRecorder::FileHeader header;
+  if( ! in.read( (char*)&header, sizeof( header ) ) || memcmp( header.magic, AllocationRecorder::MAGIC, sizeof( header.magic ) - 1 ) != 0 ) {
+    std::cout << path << " is not an allocation trace\n";
+    exit( 1 );
+  }
+  if( header.magic[ 7 ] != AllocationRecorder::MAGIC[ 7 ] ) {
+    std::cout << path << " is a version " << header.magic[ 7 ] << " allocation trace, which this benchmark cannot read; record it again\n";
+    exit( 1 );
+  }
+
+  Trace trace{ path, {}, 0 };
+  Vector<bool> live;
+  AllocationRecorder::Record record;
+  uint64_t recordedTime = 0;
+  while( in.read( (char*)&record, sizeof( record ) ) ) {
+    recordedTime += record.time;
+    if( record.id >= live.size() )
+      live.resize( record.id + 1 );
+    // A truncated or damaged trace could free a block twice or allocate into a live slot, which the replay must not.
+    if( ( record.operation == AllocationRecorder::ALLOCATE ) == live[ record.id ] ) {
+      std::cout << path << " is damaged at operation " << trace.ops.size() << "\n";
+      exit( 1 );
+    }
+    live[ record.id ] = record.operation == AllocationRecorder::ALLOCATE;
+    trace.ops.push_back( { live[ record.id ], record.size, (int)record.id } );
+  }
+  trace.numSlots = live.size();
+  if( trace.ops.empty() ) {
+    std::cout << path << " has no operations\n";
+    exit( 1 );
+  }
+
+  size_t numRecorded = trace.ops.size();
+  for( int id = 0; id < trace.numSlots; id++ )
+    if( live[ id ] )
+      trace.ops.push_back( { false, 0, id } );
+  std::cout << "Replaying " << numRecorded << " operations recorded over " << recordedTime / 1e9 << " s, with "
+            << trace.ops.size() - numRecorded << " blocks still live at the end.\n\n";
+  return trace;
+}
+
+/********************************************************************************
+*   Replay. Each trace is replayed twice on a fresh allocator. The first pass   *
+*   times every operation on its own for the latency percentiles (the clock     *
+*   reads are included in them) and samples the footprint after every           *
+*   allocation. The second pass only reads the clock at the start and the end,  *
+*   for the throughput.                                                         *
+********************************************************************************/
+template <class Allocator>
+void measureLatency( Allocator &allocator, const Trace &trace, Result &result )
+{
+  Vector<void *> slots( trace.numSlots );
+  Vector<size_t> sizes( trace.numSlots );
+  Vector<float> latencies;
+  latencies.reserve( trace.ops.size() );
+  size_t live = 0;
+
+  for( const Op &op : trace.ops ) {
+    auto before = std::chrono::steady_clock::now();
+    if( op.allocate ) {
+      slots[ op.id ] = allocator.allocate( op.size );
+      latencies.push_back( std::chrono::duration<float, std::nano>( std::chrono::steady_clock::now() - before ).count() );
+      if( slots[ op.id ] == 0 ) {
+        std::cout << "Out of memory replaying " << trace.name << "\n";
+        exit( 1 );
+      }
+      // Touch the block as a program would, unless it has no bytes to touch.
+      if( op.size != 0 )
+        *(char*)slots[ op.id ] = 1;
+      sizes[ op.id ] = op.size;
+      live += op.size;
+      size_t footprint = allocator.footprint();
+      // Fragmentation is measured against the most live data seen while the footprint was at its peak.
+      if( footprint > result.peakFootprint || ( footprint == result.peakFootprint && live > result.liveAtPeak ) ) {
+        result.peakFootprint = footprint;
+        result.liveAtPeak = live;
+      }
+    } else {
+      allocator.free( slots[ op.id ] );
+      latencies.push_back( std::chrono::duration<float, std::nano>( std::chrono::steady_clock::now() - before ).count() );
+      live -= sizes[ op.id ];
+    }
+  }
+
+  std::nth_element( latencies.begin(), latencies.begin() + latencies.size() / 2, latencies.end() );
+  result.p50 = latencies[ latencies.size() / 2 ];
+  std::nth_element( latencies.begin(), latencies.begin() + latencies.size() * 99 / 100, latencies.end() );
+  result.p99 = latencies[ latencies.size() * 99 / 100 ];
+}
+
+template <class Allocator>
+void measureThroughput( Allocator &allocator, const Trace &trace, Result &result )
+{
+  Vector<void *> slots( trace.numSlots );
+
+  auto start = std::chrono::steady_clock::now();
+  for( const Op &op : trace.ops ) {
+    if( op.allocate ) {
+      slots[ op.id ] = allocator.allocate( op.size );
+      if( op.size != 0 )
+        *(char*)slots[ op.id ] = 1;
+    } else
+      allocator.free( slots[ op.id ] );
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  result.opsPerSecond = trace.ops.size() / elapsed.count();
+}
+
+template <class Allocator>
+Result replay( const Trace &trace, size_t totalBytes )
+{
+  Result result{ 0, 0, 0, 0, 0 };
+
+  Allocator *allocator = new Allocator( totalBytes );
+  measureLatency( *allocator, trace, result );
+  delete allocator;
+
+  allocator = new Allocator( totalBytes );
+  measureThroughput( *allocator, trace, result );
+  delete allocator;
+  return result;
+}
+
+void report( const string &name, const Result &result )
+{
+  // Fragmentation is the share of the peak footprint that was not holding live data.
+  double fragmentation = result.peakFootprint == 0 ? 0 : 100.0 * ( 1.0 - double( result.liveAtPeak ) / result.peakFootprint );
+  std::cout << std::left << std::setw( 34 ) << name << std::right << std::fixed << std::setprecision( 1 )
+            << std::setw( 12 ) << result.opsPerSecond / 1e6
+            << std::setw( 10 ) << result.p50
+            << std::setw( 10 ) << result.p99
+            << std::setw( 12 ) << result.peakFootprint / 1024
+            << std::setw( 9 ) << fragmentation << "%\n";
+}
+
+void usage( const char *program )
+{
+  std::cout << "usage: " << program << " [numOps] [maxLiveBlocks] [uniform|power-law|producer/consumer|lifo]\n"
+            << "       " << program << " --replay traceFile\n";
+  exit( 1 );
+}
+
+int main( int argc, char *argv[] )
+{
+  Vector<Trace> traces;
+  string only;
+  if( argc > 1 && string( argv[1] ) == "--replay" ) {
+    if( argc != 3 )
+      usage( argv[0] );
+    traces.push_back( recordedTrace( argv[2] ) );
+  } else {
+    if( argc > 4 )
+      usage( argv[0] );
+    int numOps = argc > 1 ? atoi( argv[1] ) : 1000000;
+    int maxLive = argc > 2 ? atoi( argv[2] ) : 10000;
+    only = argc > 3 ? argv[3] : "";
+    if( numOps <= 0 || maxLive <= 0 )
+      usage( argv[0] );
+
+    traces.push_back( randomTrace( "uniform", numOps, maxLive, false, 13 ) );
+    traces.push_back( randomTrace( "power-law", numOps, maxLive, true, 13 ) );
+    traces.push_back( producerConsumerTrace( numOps, maxLive, 13 ) );
+    traces.push_back( lifoTrace( numOps, maxLive, 13 ) );
+    if( ! only.empty() && std::none_of( traces.begin(), traces.end(), [&]( const Trace &t ) { return t.name == only; } ) )
+      usage( argv[0] );
+  }
+
+  std::cout << std::left << std::setw( 34 ) << "Benchmark" << std::right << std::setw( 12 ) << "Mops/s"
+            << std::setw( 10 ) << "p50 ns" << std::setw( 10 ) << "p99 ns" << std::setw( 12 ) << "peak KiB"
+            << std::setw( 10 ) << "frag" << "\n";
+  std::cout << string( 88, '-' ) << "\n";
+
+  for( const Trace &trace : traces ) {
+    if( ! only.empty() && trace.name != only )
+      continue;
+
+    size_t totalBytes = 0;
+    for( const Op &op : trace.ops )
+      totalBytes += ( op.size + 15 ) & ~(size_t)15;
+
+    report( trace.name + "/BoundaryTag", replay<BoundaryTagAllocator>( trace, totalBytes ) );
+    report( trace.name + "/malloc", replay<MallocAllocator>( trace, totalBytes ) );
+    report( trace.name + "/bump", replay<BumpAllocator>( trace, totalBytes ) );
+  }
+  std::cout << "\nmalloc's peak is glibc's heap size less what was in use before the trace. glibc grows and trims its\n"
+            << "heap 128 KiB at a time, so when that peak is only a few hundred KiB its fragmentation is mostly that.\n";
+  return 0;
+}
@@ -0,0 +1,275 @@
+#include "BoundaryTag.hpp"
+#include<iostream>
+#include<string>
+#include<string.h>
+#include<stdlib.h>
+#include<stdint.h>
+#include<vector>
+#include<signal.h>
+#include<unistd.h>
+#include<sys/wait.h>
+
+using namespace std;
+
+// make checkApp.x builds this driver with HEAP_CHECKS, and make checkDeferredApp.x with DEFERRED_COALESCING as well.
+#if !HEAP_CHECKS
+#error "checkDriver.cpp tests the checked heap, so it must be built with -DHEAP_CHECKS=true"
+#endif
+
+const int NUM_STEPS = 20000;
+const int VALIDATE_EVERY = 50;
+const int MAX_BYTES = 300;
+const int BATCH_SIZE = 8;
+
+template <Placement Policy>
+using PolicyBoundaryTag = BasicBoundaryTag<BoundaryTag::CAPACITY, BoundaryTag::Word, Policy>;
+
+struct Block {
+  unsigned char *ptr;
+  size_t bytes;
+  unsigned char pattern;
+};
+
+// Runs misuse on a fresh heap in a child process, which the heap should abort after reporting a problem that
+// contains expected on stderr. Returns false, after saying what happened instead, if it did not.
+bool reports( const char *name, void ( *misuse )( BoundaryTag * ), const char *expected )
+{
+  int fds[ 2 ];
+  if( pipe( fds ) != 0 ) {
+    std::cout << "Cannot make a pipe\n";
+    exit( 1 );
+  }
+  // The heap's report goes to std::cerr, which flushes std::cout first, so the child must not inherit unwritten output.
+  std::cout.flush();
+  pid_t child = fork();
+  if( child == 0 ) {
+    dup2( fds[ 1 ], 2 );
+    close( fds[ 0 ] );
+    misuse( new BoundaryTag() );
+    _exit( 0 );
+  }
+  close( fds[ 1 ] );
+  string report;
+  char buffer[ 256 ];
+  ssize_t n;
+  while( ( n = read( fds[ 0 ], buffer, sizeof( buffer ) ) ) > 0 )
+    report.append( buffer, n );
+  close( fds[ 0 ] );
+  int status;
+  waitpid( child, &status, 0 );
+
+  if( report.size() > 0 && report.back() == '\n' )
+    report.pop_back();
+  if( ! WIFSIGNALED( status ) || WTERMSIG( status ) != SIGABRT || report.find( expected ) == string::npos ) {
+    std::cout << name << ": expected \"" << expected << "\" and an abort, got \"" << report << "\" and "
+              << ( WIFSIGNALED( status ) ? "signal " : "exit status " )
+              << ( WIFSIGNALED( status ) ? WTERMSIG( status ) : WEXITSTATUS( status ) ) << "\n";
+    return false;
+  }
+  std::cout << name << ": " << report << "\n";
+  return true;
+}
+
+void doubleFree( BoundaryTag *memory )
+{
+  void *ptr = memory->allocate( 40 );
+  memory->free( ptr );
+  memory->free( ptr );
+}
+
+// The second block is coalesced with the first once both are freed, so the first block's tags are gone.
+void doubleFreeAfterCoalescing( BoundaryTag *memory )
+{
+  void *first = memory->allocate( 40 );
+  void *second = memory->allocate( 40 );
+  memory->allocate( 40 );
+  memory->free( first );
+  memory->free( second );
+  memory->free( first );
+}
+
+void overflow( BoundaryTag *memory )
+{
+  unsigned char *ptr = (unsigned char*)memory->allocate( 40 );
+  ptr[ 40 ] = 0;
+  memory->free( ptr );
+}
+
+void underflowIntoMagic( BoundaryTag *memory )
+{
+  unsigned char *ptr = (unsigned char*)memory->allocate( 40 );
+  ptr[ -1 ] = 0;
+  memory->free( ptr );
+}
+
+void underflowIntoTag( BoundaryTag *memory )
+{
+  BoundaryTag::Word *ptr = (BoundaryTag::Word*)memory->allocate( 40 );
+  ptr[ -BoundaryTag::HEADER_WORDS ] = 1024;
+  memory->free( ptr );
+}
+
+void foreignPointer( BoundaryTag *memory )
+{
+  int64_t local[ 8 ] = {};
+  memory->free( local + 4 );
+}
+
+void interiorPointer( BoundaryTag *memory )
+{
+  unsigned char *ptr = (unsigned char*)memory->allocate( 200 );
+  memory->free( ptr + 64 );
+}
+
+void reallocateFreed( BoundaryTag *memory )
+{
+  void *ptr = memory->allocate( 40 );
+  memory->allocate( 40 );
+  memory->free( ptr );
+  memory->reallocate( ptr, 80 );
+}
+
+void freeTwiceInOneBatch( BoundaryTag *memory )
+{
+  void *ptrs[ 2 ];
+  ptrs[ 0 ] = ptrs[ 1 ] = memory->allocate( 40 );
+  memory->free_batch( ptrs, 2 );
+}
+
+// validate() only reports, so the child aborts itself when it fails.
+void overflowFoundByValidate( BoundaryTag *memory )
+{
+  unsigned char *ptr = (unsigned char*)memory->allocate( 40 );
+  memory->allocate( 40 );
+  ptr[ 43 ] = 0;
+  if( ! memory->validate() )
+    abort();
+}
+
+// Checks that nothing wrote over b, then frees it.
+template <class Heap>
+void freeBlock( Heap *memory, const Block &b, const char *name )
+{
+  for( size_t i = 0; i < b.bytes; i++ )
+    if( b.ptr[ i ] != b.pattern ) {
+      std::cout << name << ": block at " << (void*)b.ptr << " was overwritten\n";
+      exit( 1 );
+    }
+  memory->free( b.ptr );
+}
+
+// Runs NUM_STEPS random allocates, aligned allocates, callocates, reallocates, frees and batches on a fresh heap,
+// calling validate() every VALIDATE_EVERY steps and once everything is freed again.
+template <class Heap>
+bool validatesUnderLoad( const char *name )
+{
+  Heap *memory = new Heap();
+  vector<Block> blocks;
+  int numValidates = 0;
+  for( int step = 1; step <= NUM_STEPS; step++ ) {
+    int action = rand() % 100;
+    size_t n = rand() % MAX_BYTES + 1;
+    unsigned char *ptr = 0;
+    if( action < 30 )
+      ptr = (unsigned char*)memory->allocate( n );
+    else if( action < 38 )
+      ptr = (unsigned char*)memory->allocate_aligned( n, (size_t)16 << ( rand() % 4 ) );
+    else if( action < 43 ) {
+      ptr = (unsigned char*)memory->callocate( n, 1 );
+      for( size_t i = 0; ptr && i < n; i++ )
+        if( ptr[ i ] != 0 ) {
+          std::cout << name << ": callocate returned memory that is not zero\n";
+          exit( 1 );
+        }
+    } else if( action < 46 ) {
+      void *batch[ BATCH_SIZE ];
+      size_t numAllocated = memory->allocate_batch( n, BATCH_SIZE, batch );
+      for( size_t i = 0; i < numAllocated; i++ ) {
+        memset( batch[ i ], (unsigned char)step, n );
+        blocks.push_back( { (unsigned char*)batch[ i ], n, (unsigned char)step } );
+      }
+    } else if( action < 60 && ! blocks.empty() ) {
+      int idx = rand() % blocks.size();
+      Block &b = blocks[ idx ];
+      unsigned char *moved = (unsigned char*)memory->reallocate( b.ptr, n );
+      if( moved ) {
+        for( size_t i = 0; i < min( n, b.bytes ); i++ )
+          if( moved[ i ] != b.pattern ) {
+            std::cout << name << ": reallocate lost the contents of a block\n";
+            exit( 1 );
+          }
+        memset( moved, b.pattern, n );
+        b.ptr = moved;
+        b.bytes = n;
+      }
+    } else if( action < 62 && blocks.size() >= BATCH_SIZE ) {
+      void *batch[ BATCH_SIZE ];
+      for( int i = 0; i < BATCH_SIZE; i++ ) {
+        int idx = rand() % blocks.size();
+        batch[ i ] = blocks[ idx ].ptr;
+        blocks[ idx ] = blocks.back();
+        blocks.pop_back();
+      }
+      memory->free_batch( batch, BATCH_SIZE );
+    } else if( ! blocks.empty() ) {
+      int idx = rand() % blocks.size();
+      freeBlock( memory, blocks[ idx ], name );
+      blocks[ idx ] = blocks.back();
+      blocks.pop_back();
+    }
+    if( ptr ) {
+      unsigned char pattern = rand();
+      memset( ptr, pattern, n );
+      blocks.push_back( { ptr, n, pattern } );
+    }
+
+    if( step % VALIDATE_EVERY == 0 ) {
+      if( ! memory->validate() ) {
+        std::cout << name << ": validate() failed after " << step << " steps\n";
+        return false;
+      }
+      numValidates++;
+    }
+  }
+
+  for( const Block &b : blocks )
+    freeBlock( memory, b, name );
+  if( ! memory->validate() || ! memory->isEmpty() ) {
+    std::cout << name << ": memory is not one valid free space once every block is freed\n";
+    return false;
+  }
+  std::cout << name << ": validate() passed " << numValidates + 1 << " times over " << NUM_STEPS << " steps\n";
+  delete memory;
+  return true;
+}
+
+int main()
+{
+  srand( 13 );
+  bool passed = true;
+
+  passed &= reports( "double free", doubleFree, "double free" );
+  passed &= reports( "double free after coalescing", doubleFreeAfterCoalescing, "double free" );
+  passed &= reports( "overflow past the canary", overflow, "write past the end" );
+  passed &= reports( "underflow into the magic word", underflowIntoMagic, "header written over" );
+  passed &= reports( "underflow into the boundary tag", underflowIntoTag, "boundary tags written over" );
+  passed &= reports( "pointer outside of the heap", foreignPointer, "outside of the heap" );
+  passed &= reports( "pointer into the middle of a block", interiorPointer, "not allocated" );
+  passed &= reports( "reallocate of a freed block", reallocateFreed, "double free" );
+  passed &= reports( "block freed twice in one batch", freeTwiceInOneBatch, "freed twice" );
+  passed &= reports( "overflow found by validate()", overflowFoundByValidate, "write past the end" );
+
+  passed &= validatesUnderLoad<PolicyBoundaryTag<Placement::SEGREGATED_FIT>>( "SEGREGATED_FIT" );
+  passed &= validatesUnderLoad<PolicyBoundaryTag<Placement::FIRST_FIT>>( "FIRST_FIT" );
+  passed &= validatesUnderLoad<PolicyBoundaryTag<Placement::NEXT_FIT>>( "NEXT_FIT" );
+  passed &= validatesUnderLoad<PolicyBoundaryTag<Placement::ADDRESS_ORDERED>>( "ADDRESS_ORDERED" );
+  passed &= validatesUnderLoad<PolicyBoundaryTag<Placement::BEST_FIT>>( "BEST_FIT" );
+  passed &= validatesUnderLoad<TinyBoundaryTag>( "TinyBoundaryTag" );
+
+  if( ! passed ) {
+    std::cout << "The checked heap missed a problem.\n";
+    return 1;
+  }
+  std::cout << "Every problem was reported and every heap validated" << ( DEFERRED_COALESCING ? " with deferred coalescing" : "" ) << ".\n";
+  return 0;
+}
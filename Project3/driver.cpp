@@ -3,11 +3,11 @@
 #include<string.h>
 #include<stdlib.h>
 #include<vector>
+#include<chrono>
+#include<algorithm>
 
 using namespace std;
 
-enum { SIZE = 4096, BYTES_PER_WORD = sizeof(int), FREE_OVERHEAD = 4 }; 
-
 class MemoryBlock {
 public:
   MemoryBlock( void *memory, int bytes ): mPtr( memory ), sizeInBytes( bytes ) {}
@@ -49,15 +49,82 @@ private:
 void assertMemorySize( BoundaryTag *memory, int where )
 {
   memory->start();
-  int numBytes = 0;
+  size_t numBytes = 0;
   while( void *ptr = memory->next() )
   {
     numBytes += memory->size( ptr );
   }
       
-  if( numBytes != SIZE * BYTES_PER_WORD ) 
+  if( numBytes != BoundaryTag::CAPACITY ) 
+  {
+    std::cout << "Total number of bytes is " << numBytes << " instead of " << BoundaryTag::CAPACITY << " at " << where << "\n";
+    exit( 1 );
+  }
+}
+
+// Checks what stats() reports against a walk of every space with spaces(), which coalesces any parked blocks first.
+void assertStatsMatch( BoundaryTag *memory, int where )
+{
+  size_t bytesInUse = 0, numFreeBlocks = 0, largestFreeBlock = 0;
+  for( BoundaryTag::Space space : memory->spaces() )
+  {
+    if( space.free )
+    {
+      numFreeBlocks++;
+      largestFreeBlock = std::max( largestFreeBlock, space.bytes );
+    }
+    else
+      bytesInUse += space.bytes;
+  }
+
+  BoundaryTag::Stats stats = memory->stats();
+  size_t histogramTotal = 0;
+  for( size_t count : stats.freeHistogram )
+    histogramTotal += count;
+  if( stats.bytesInUse != bytesInUse || stats.bytesFree != BoundaryTag::CAPACITY - bytesInUse ||
+      stats.numFreeBlocks != numFreeBlocks || histogramTotal != numFreeBlocks ||
+      stats.largestFreeBlock != largestFreeBlock )
+  {
+    std::cout << "stats() reports " << stats.bytesInUse << " bytes in use, " << stats.numFreeBlocks
+              << " free blocks and a largest free block of " << stats.largestFreeBlock << " bytes instead of "
+              << bytesInUse << ", " << numFreeBlocks << " and " << largestFreeBlock << " at " << where << "\n";
+    exit( 1 );
+  }
+}
+
+// Checks that the spaces spaces() yields cover all of memory, that their free and allocated counts agree with stats(),
+// and that snapshot() records the same spaces in the same order.
+void assertSpacesMatch( BoundaryTag *memory, BoundaryTag::Snapshot *snapshot, int where )
+{
+  memory->snapshot( *snapshot );
+  BoundaryTag::Stats stats = memory->stats();
+  size_t numBytes = 0, numFree = 0, numUsed = 0, i = 0;
+  BoundaryTag::Word *first = nullptr;
+  for( BoundaryTag::Space space : memory->spaces() )
+  {
+    BoundaryTag::Word *tag = (BoundaryTag::Word*)space.address;
+    if( first == nullptr )
+      first = tag;
+    if( i >= snapshot->numSpaces || snapshot->index[ i ] != (size_t)( tag - first ) ||
+        snapshot->numWords[ i ] * sizeof( BoundaryTag::Word ) != space.bytes || snapshot->isFree( i ) != space.free )
+    {
+      std::cout << "snapshot() does not match space " << i << " of spaces() at " << where << "\n";
+      exit( 1 );
+    }
+    numBytes += space.bytes;
+    if( space.free )
+      numFree++;
+    else
+      numUsed++;
+    i++;
+  }
+
+  if( numBytes != BoundaryTag::CAPACITY || i != snapshot->numSpaces || numFree != stats.numFreeBlocks ||
+      numUsed != stats.numAllocates - stats.numFrees )
   {
-    std::cout << "Total number of bytes is " << numBytes << " instead of " << SIZE * BYTES_PER_WORD << " at " << where << "\n";
+    std::cout << "spaces() yields " << i << " spaces of " << numBytes << " bytes, " << numFree << " free and " << numUsed
+              << " allocated, where snapshot() has " << snapshot->numSpaces << " and stats() " << stats.numFreeBlocks
+              << " free and " << stats.numAllocates - stats.numFrees << " allocated at " << where << "\n";
     exit( 1 );
   }
 }
@@ -73,12 +140,17 @@ int main( )
   std::cout << "Up to this point, you have earned 20 points.\n";
 
   BlockCollection *collection = new BlockCollection();
+  // A Snapshot holds an entry for every space memory could have, so it is too big for the stack.
+  BoundaryTag::Snapshot *snapshot = new BoundaryTag::Snapshot();
 
   int allocatePercentage = 55;
   int maxSize = 150;
 
   void* block;
   int numIterations = 0;
+  // Time spent inside allocate and free only, so the cost of assertMemorySize is not counted.
+  std::chrono::nanoseconds allocateTime{0}, freeTime{0};
+  int numAllocates = 0, numFrees = 0;
     // If your program dies in this loop, 
     // you will not be able to make more than 40 out of 100.
   while( true ) 
@@ -87,7 +159,10 @@ int main( )
     if( rand() % 100 < allocatePercentage ) 
     {
 	    int n = rand() % maxSize + 1;
+	    auto before = std::chrono::steady_clock::now();
 	    block = memory->allocate( n );
+	    allocateTime += std::chrono::steady_clock::now() - before;
+	    numAllocates++;
 	    if( block == 0 ) // out of memory?
 	      break;
 	    collection->add( block, n );
@@ -95,16 +170,23 @@ int main( )
     else if( ! collection->empty() ) 
     {
 	    MemoryBlock *mb = collection->getAMemoryBlock();
+	    auto before = std::chrono::steady_clock::now();
 	    memory->free( mb->pointerToMemoryOfThisBlock() );
+	    freeTime += std::chrono::steady_clock::now() - before;
+	    numFrees++;
 	    delete mb;
 	  }
 	  collection->clearMemoryBlocks();
     assertMemorySize(memory, 2);
+    assertStatsMatch(memory, 2);
+    assertSpacesMatch(memory, snapshot, 2);
   }
 
   std::cout << "You have earned 65 points.\n";
 
   std::cout << "Iterated " << numIterations << " times. There are " << collection->numBlocks() << " free blocks.\n";
+  std::cout << "Average allocate: " << allocateTime.count() / std::max( numAllocates, 1 ) << " ns, average free: "
+            << freeTime.count() / std::max( numFrees, 1 ) << " ns.\n";
 
   while( ! collection->empty() ) 
   {
@@ -114,18 +196,23 @@ int main( )
   }
 
   assertMemorySize(memory, 3);
+  assertStatsMatch(memory, 3);
+  assertSpacesMatch(memory, snapshot, 3);
   std::cout << "You have earned 75 points.\n";
 
-  if( memory->allocate( SIZE * BYTES_PER_WORD - 100 ) == 0 ) 
+  if( memory->allocate( BoundaryTag::CAPACITY - 100 ) == 0 ) 
   {
     std::cout << "Memory is not being coalesced!  This feature is worth 15 out of 100 points!\n";
     exit( 2 );
   }
 
   assertMemorySize(memory, 4);
+  assertStatsMatch(memory, 4);
+  assertSpacesMatch(memory, snapshot, 4);
   std::cout << "Well done!  You have earned 90 points.  \n";
 
   delete memory;
   delete collection;
+  delete snapshot;
   return 0;
 }
@@ -5,8 +5,6 @@
 
 using namespace std;
 
-enum { SIZE = 4096, BYTES_PER_WORD = sizeof(int), FREE_OVERHEAD = 4 }; 
-
 class BlockCollection {
 public:
     BlockCollection() { collection.clear(); }
@@ -28,12 +26,12 @@ private:
 void assertMemorySize( BoundaryTag *memory, int where )
 {
     memory->start();
-    int numBytes = 0;
+    size_t numBytes = 0;
     while( void *ptr = memory->next() )
         numBytes += memory->size( ptr );
-    if( numBytes != SIZE * BYTES_PER_WORD ) {
+    if( numBytes != BoundaryTag::CAPACITY ) {
         std::cout << "Total number of bytes is " << numBytes << " instead of " << 
-            SIZE * BYTES_PER_WORD << " at " << where << "\n";
+            BoundaryTag::CAPACITY << " at " << where << "\n";
         exit( 1 );
     }
 }
@@ -80,7 +78,7 @@ int main( )
     assertMemorySize(memory, 3);
     std::cout << "You have earned 75 points.\n";
 
-    if( memory->allocate( SIZE * BYTES_PER_WORD - 100 ) == 0 ) {
+    if( memory->allocate( BoundaryTag::CAPACITY - 100 ) == 0 ) {
         std::cout << "Memory is not being coalesced!  This feature is worth 15 out of 100 points!\n";
         exit( 2 );
     }
@@ -0,0 +1,106 @@
+#include "BoundaryTag.hpp"
+#include<iostream>
+#include<stdlib.h>
+#include<vector>
+#include<chrono>
+
+using namespace std;
+
+const int NUM_PAIRS = 10000000;
+const int NUM_SIZES = 4096;
+const int NUM_LIVE = 100;
+const int NUM_BATCHES = 200000;
+const int BATCH_SIZE = 32;
+const int NODE_BYTES = 48;
+
+// Measures the cost of one allocate immediately followed by the free of the same block, with numLive blocks kept
+// allocated so the heap is fragmented and the free has neighbours to coalesce with. The sizes are drawn up front so
+// rand() is not timed.
+template <class Heap>
+double nsPerPair( Heap *memory, const vector<int> &sizes, int numLive )
+{
+  vector<void *> live;
+  for( int i = 0; i < numLive; i++ ) {
+    live.push_back( memory->allocate( sizes[ i ] ) );
+    memory->allocate( sizes[ i + numLive ] ); // never freed, keeps the live blocks apart
+  }
+  for( int i = 0; i < numLive; i += 2 )
+    memory->free( live[ i ] );
+
+  void *sink = 0;
+  auto before = std::chrono::steady_clock::now();
+  for( int i = 0; i < NUM_PAIRS; i++ ) {
+    void *block = memory->allocate( sizes[ i & ( NUM_SIZES - 1 ) ] );
+    sink = block;
+    memory->free( block );
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - before;
+
+  if( sink == 0 ) {
+    std::cout << "allocate failed\n";
+    exit( 1 );
+  }
+  return elapsed.count() / NUM_PAIRS;
+}
+
+// nsPerPair on a fresh 32 KiB heap that places blocks by Policy.
+template <Placement Policy>
+double nsPerPairWith( const vector<int> &sizes )
+{
+  typedef BasicBoundaryTag<BoundaryTag::CAPACITY, BoundaryTag::Word, Policy> Heap;
+  Heap *memory = new Heap();
+  double ns = nsPerPair( memory, sizes, NUM_LIVE );
+  delete memory;
+  return ns;
+}
+
+int main()
+{
+  BoundaryTag *memory = new BoundaryTag();
+  srand( 13 );
+
+  vector<int> sizes( NUM_SIZES );
+  for( int i = 0; i < NUM_SIZES; i++ )
+    sizes[ i ] = rand() % 150 + 9;
+
+  std::cout << "allocate/free pair: " << nsPerPair( memory, sizes, NUM_LIVE ) << " ns\n";
+
+  // The same under the other placement policies, each its own instance of BasicBoundaryTag.
+  std::cout << "allocate/free pair: " << nsPerPairWith<Placement::FIRST_FIT>( sizes ) << " ns FIRST_FIT, "
+            << nsPerPairWith<Placement::NEXT_FIT>( sizes ) << " ns NEXT_FIT, "
+            << nsPerPairWith<Placement::ADDRESS_ORDERED>( sizes ) << " ns ADDRESS_ORDERED, "
+            << nsPerPairWith<Placement::BEST_FIT>( sizes ) << " ns BEST_FIT\n";
+
+  // The same on an 8 KiB heap with 32-bit tags, which has room for fewer live blocks, and on a 16 MiB heap.
+  TinyBoundaryTag *tiny = new TinyBoundaryTag();
+  LargeBoundaryTag *large = new LargeBoundaryTag();
+  std::cout << "allocate/free pair: " << nsPerPair( tiny, sizes, NUM_LIVE / 4 ) << " ns on TinyBoundaryTag, "
+            << nsPerPair( large, sizes, NUM_LIVE ) << " ns on LargeBoundaryTag\n";
+  delete tiny;
+  delete large;
+
+  // BATCH_SIZE same-sized nodes allocated together and freed together, one call at a time and then as a batch.
+  void *nodes[ BATCH_SIZE ];
+  auto before = std::chrono::steady_clock::now();
+  for( int i = 0; i < NUM_BATCHES; i++ ) {
+    for( int j = 0; j < BATCH_SIZE; j++ )
+      nodes[ j ] = memory->allocate( NODE_BYTES );
+    for( int j = 0; j < BATCH_SIZE; j++ )
+      memory->free( nodes[ j ] );
+  }
+  std::chrono::duration<double, std::nano> oneAtATime = std::chrono::steady_clock::now() - before;
+
+  before = std::chrono::steady_clock::now();
+  for( int i = 0; i < NUM_BATCHES; i++ ) {
+    if( memory->allocate_batch( NODE_BYTES, BATCH_SIZE, nodes ) != BATCH_SIZE ) {
+      std::cout << "allocate_batch failed\n";
+      return 1;
+    }
+    memory->free_batch( nodes, BATCH_SIZE );
+  }
+  std::chrono::duration<double, std::nano> batched = std::chrono::steady_clock::now() - before;
+  std::cout << BATCH_SIZE << " x " << NODE_BYTES << " byte nodes: " << oneAtATime.count() / NUM_BATCHES
+            << " ns one at a time, " << batched.count() / NUM_BATCHES << " ns as a batch\n";
+  delete memory;
+  return 0;
+}
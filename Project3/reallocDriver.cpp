@@ -0,0 +1,147 @@
+#include "BoundaryTag.hpp"
+#include<iostream>
+#include<string.h>
+#include<stdlib.h>
+#include<stdint.h>
+
+using namespace std;
+
+template <Placement Policy>
+using PolicyBoundaryTag = BasicBoundaryTag<BoundaryTag::CAPACITY, BoundaryTag::Word, Policy>;
+
+const unsigned char PATTERN = 0xA5;
+
+// Stops the driver with a message if a check fails.
+void check( bool passed, const char *name, const char *what )
+{
+  if( ! passed ) {
+    std::cout << name << ": " << what << "\n";
+    exit( 1 );
+  }
+}
+
+bool holdsPattern( const void *ptr, size_t bytes )
+{
+  for( size_t i = 0; i < bytes; i++ )
+    if( ( (const unsigned char*)ptr )[ i ] != PATTERN )
+      return false;
+  return true;
+}
+
+bool isZero( const void *ptr, size_t bytes )
+{
+  for( size_t i = 0; i < bytes; i++ )
+    if( ( (const unsigned char*)ptr )[ i ] != 0 )
+      return false;
+  return true;
+}
+
+// With DEFERRED_COALESCING a freed block is only parked. Walking the spaces coalesces parked blocks, so the space a
+// test frees is really free afterwards.
+template <class Heap>
+void settle( Heap *memory )
+{
+  memory->spaces();
+}
+
+// Size in bytes of the whole space holding the block at ptr, tags included. With HEAP_CHECKS usableSize() is only the
+// bytes asked for, so this is what shows whether a block moved into or gave back space.
+template <class Heap>
+size_t spaceBytes( Heap *memory, void *ptr )
+{
+  return memory->size( (typename Heap::Word*)ptr - Heap::HEADER_WORDS );
+}
+
+// Every policy carves a block off the end of the free space it picks, so on a fresh heap the second block sits right
+// in front of the first.
+template <class Heap>
+void allocateNeighbours( Heap *memory, size_t bytes, unsigned char *&left, unsigned char *&right, const char *name )
+{
+  right = (unsigned char*)memory->allocate( bytes );
+  left = (unsigned char*)memory->allocate( bytes );
+  check( left && right && left + spaceBytes( memory, left ) == right, name,
+         "two blocks allocated from a fresh heap are not next to each other" );
+  memset( left, PATTERN, bytes );
+}
+
+// Runs every reallocate and callocate case on fresh heaps of type Heap.
+template <class Heap>
+void runCases( const char *name )
+{
+  // Growing into a free neighbour on the right keeps the block where it is.
+  Heap *memory = new Heap();
+  unsigned char *left, *right;
+  allocateNeighbours( memory, 100, left, right, name );
+  memory->free( right );
+  settle( memory );
+  size_t numAllocates = memory->stats().numAllocates;
+  check( memory->reallocate( left, 180 ) == left, name, "did not grow in place into the free space on its right" );
+  check( memory->usableSize( left ) >= 180 && holdsPattern( left, 100 ), name, "lost bytes growing in place" );
+  check( memory->stats().numAllocates == numAllocates && memory->validate(), name, "heap is wrong after growing in place" );
+  delete memory;
+
+  // Shrinking keeps the block where it is and gives the tail back as a free space.
+  memory = new Heap();
+  unsigned char *ptr = (unsigned char*)memory->allocate( 1000 );
+  memset( ptr, PATTERN, 1000 );
+  size_t bytesInUse = memory->stats().bytesInUse;
+  check( memory->reallocate( ptr, 100 ) == ptr && holdsPattern( ptr, 100 ), name, "did not shrink in place" );
+  check( memory->stats().bytesInUse <= bytesInUse - 800, name, "did not give back the tail of a shrunk block" );
+  check( spaceBytes( memory, ptr ) < 1000 && memory->validate(), name, "heap is wrong after shrinking in place" );
+  // A shrink that leaves too little to make a free space keeps the block as it is.
+  bytesInUse = memory->stats().bytesInUse;
+  size_t usable = memory->usableSize( ptr );
+  size_t space = spaceBytes( memory, ptr );
+  check( memory->resizeInPlace( ptr, usable - 1 ) && spaceBytes( memory, ptr ) == space, name, "split a block shrunk by one byte" );
+  check( memory->stats().bytesInUse == bytesInUse && memory->validate(), name, "heap is wrong after shrinking by one byte" );
+  delete memory;
+
+  // With an allocated neighbour on the right the block has to move, and its bytes go with it.
+  memory = new Heap();
+  allocateNeighbours( memory, 100, left, right, name );
+  memset( right, PATTERN, 100 );
+  space = spaceBytes( memory, left );
+  check( ! memory->resizeInPlace( left, 500 ) && spaceBytes( memory, left ) == space, name,
+         "resizeInPlace changed a block that cannot grow" );
+  unsigned char *moved = (unsigned char*)memory->reallocate( left, 500 );
+  check( moved && moved != left && holdsPattern( moved, 100 ), name, "did not move and copy a block that cannot grow" );
+  check( holdsPattern( right, 100 ) && memory->stats().numFrees == 1 && memory->validate(), name,
+         "heap is wrong after moving a block" );
+  delete memory;
+
+  // A null pointer is an allocate, a size of 0 a free, and a size that cannot fit leaves the block alone.
+  memory = new Heap();
+  ptr = (unsigned char*)memory->reallocate( nullptr, 64 );
+  check( ptr && memory->usableSize( ptr ) >= 64 && memory->stats().numAllocates == 1, name, "reallocate( nullptr, n ) did not allocate" );
+  memset( ptr, PATTERN, 64 );
+  check( memory->reallocate( ptr, Heap::CAPACITY + 1 ) == nullptr && holdsPattern( ptr, 64 ), name,
+         "a reallocate that cannot fit changed the block" );
+  check( memory->reallocate( ptr, 0 ) == nullptr && memory->stats().numFrees == 1, name, "reallocate( p, 0 ) did not free" );
+  check( memory->stats().bytesInUse == 0 && memory->isEmpty(), name, "reallocate( p, 0 ) left memory in use" );
+  delete memory;
+
+  // callocate refuses sizes whose product overflows, and clears memory that was handed out before.
+  memory = new Heap();
+  check( memory->callocate( SIZE_MAX / 2, 4 ) == nullptr, name, "callocate did not refuse an overflowing size" );
+  ptr = (unsigned char*)memory->callocate( 300, 1 );
+  check( ptr && isZero( ptr, 300 ), name, "callocate of fresh memory is not zero" );
+  memset( ptr, PATTERN, 300 );
+  memory->free( ptr );
+  unsigned char *reused = (unsigned char*)memory->callocate( 300, 1 );
+  check( reused == ptr, name, "callocate did not reuse the block just freed" );
+  check( isZero( reused, 300 ), name, "callocate of reused memory is not zero" );
+  delete memory;
+
+  std::cout << name << ": grow, shrink, move, nullptr, 0 and callocate cases passed\n";
+}
+
+int main()
+{
+  runCases<PolicyBoundaryTag<Placement::SEGREGATED_FIT>>( "SEGREGATED_FIT" );
+  runCases<PolicyBoundaryTag<Placement::FIRST_FIT>>( "FIRST_FIT" );
+  runCases<PolicyBoundaryTag<Placement::NEXT_FIT>>( "NEXT_FIT" );
+  runCases<PolicyBoundaryTag<Placement::ADDRESS_ORDERED>>( "ADDRESS_ORDERED" );
+  runCases<PolicyBoundaryTag<Placement::BEST_FIT>>( "BEST_FIT" );
+  runCases<TinyBoundaryTag>( "TinyBoundaryTag" );
+  return 0;
+}
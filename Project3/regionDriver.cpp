@@ -0,0 +1,106 @@
+#include "Region.hpp"
+#include<iostream>
+#include<string.h>
+#include<stdlib.h>
+#include<vector>
+#include<chrono>
+
+using namespace std;
+
+const int NUM_REQUESTS = 200000;
+const int MAX_OBJECTS = 60;
+const int MAX_OBJECT_BYTES = 200;
+const int REGION_BYTES = 16 * 1024;
+
+struct Block {
+  unsigned char *ptr;
+  size_t bytes;
+  unsigned char pattern;
+};
+
+// Allocates one request's worth of objects: between 20 and MAX_OBJECTS of 9 to MAX_OBJECT_BYTES bytes. Returns false
+// if the heap ran out of room.
+template <class Heap>
+bool handleRequest( Heap *heap, vector<Block> &blocks, const vector<int> &sizes, int &next )
+{
+  int numObjects = sizes[ next++ % sizes.size() ] % ( MAX_OBJECTS - 20 ) + 20;
+  for( int i = 0; i < numObjects; i++ ) {
+    size_t n = sizes[ next++ % sizes.size() ];
+    unsigned char *ptr = (unsigned char*)heap->allocate( n );
+    if( ptr == 0 )
+      return false;
+    blocks.push_back( { ptr, n, (unsigned char)n } );
+  }
+  return true;
+}
+
+// Fills every object of the request with its pattern and checks that none was written over by another.
+void checkBlocks( const vector<Block> &blocks )
+{
+  for( const Block &b : blocks )
+    memset( b.ptr, b.pattern, b.bytes );
+  for( const Block &b : blocks )
+    for( size_t j = 0; j < b.bytes; j++ )
+      if( b.ptr[ j ] != b.pattern ) {
+        std::cout << "Block at " << (void*)b.ptr << " was overwritten\n";
+        exit( 1 );
+      }
+}
+
+// Serves NUM_REQUESTS requests twice: once freeing every object with BoundaryTag::free, and once from a Region that
+// is reset at the end of each request. Only the allocating and the freeing or resetting are timed.
+int main()
+{
+  srand( 13 );
+  BoundaryTag *memory = new BoundaryTag();
+  vector<int> sizes( 4096 );
+  for( int &n : sizes )
+    n = rand() % ( MAX_OBJECT_BYTES - 8 ) + 9;
+  vector<Block> blocks;
+
+  int next = 0;
+  std::chrono::nanoseconds freed{0}, reset{0};
+  for( int r = 0; r < NUM_REQUESTS; r++ ) {
+    auto before = std::chrono::steady_clock::now();
+    if( ! handleRequest( memory, blocks, sizes, next ) ) {
+      std::cout << "The heap ran out of room\n";
+      exit( 1 );
+    }
+    freed += std::chrono::steady_clock::now() - before;
+    checkBlocks( blocks );
+    before = std::chrono::steady_clock::now();
+    for( Block &b : blocks )
+      memory->free( b.ptr );
+    freed += std::chrono::steady_clock::now() - before;
+    blocks.clear();
+  }
+
+  next = 0;
+  {
+    Region region( memory, REGION_BYTES );
+    for( int r = 0; r < NUM_REQUESTS; r++ ) {
+      auto before = std::chrono::steady_clock::now();
+      if( ! handleRequest( &region, blocks, sizes, next ) ) {
+        std::cout << "The region ran out of room\n";
+        exit( 1 );
+      }
+      reset += std::chrono::steady_clock::now() - before;
+      checkBlocks( blocks );
+      before = std::chrono::steady_clock::now();
+      region.reset();
+      reset += std::chrono::steady_clock::now() - before;
+      blocks.clear();
+    }
+  }
+
+  std::cout << "Request of 20-" << MAX_OBJECTS << " objects: " << (double)freed.count() / NUM_REQUESTS
+            << " ns freeing each object, " << (double)reset.count() / NUM_REQUESTS << " ns resetting a region.\n";
+
+  // The region's block went back to the heap when the region went out of scope.
+  if( ! memory->isEmpty() ) {
+    std::cout << "The region was not returned to the heap!\n";
+    exit( 2 );
+  }
+  delete memory;
+  return 0;
+}
@@ -0,0 +1,126 @@
+#include "SlabHeap.hpp"
+#include<iostream>
+#include<string.h>
+#include<stdlib.h>
+#include<vector>
+#include<chrono>
+
+using namespace std;
+
+const int NUM_OPS = 1000000;
+const int NUM_PAIRS = 10000000;
+const int MAX_SMALL = 64;
+
+struct Block {
+  unsigned char *ptr;
+  size_t bytes;
+  unsigned char pattern;
+};
+
+// The driver.cpp workload on a SlabHeap: allocate 1-150 bytes 55% of the time, otherwise free a random live block
+// after checking that nothing else wrote over it. Allocations that do not fit are counted and skipped.
+void churn( SlabHeap *slabs )
+{
+  vector<Block> blocks;
+  int failed = 0;
+
+  for( int i = 0; i < NUM_OPS; i++ ) {
+    if( rand() % 100 < 55 ) {
+      size_t n = rand() % 150 + 1;
+      unsigned char *ptr = (unsigned char*)slabs->allocate( n );
+      if( ptr == 0 ) {
+        failed++;
+        continue;
+      }
+      unsigned char pattern = rand();
+      memset( ptr, pattern, n );
+      blocks.push_back( { ptr, n, pattern } );
+    } else if( ! blocks.empty() ) {
+      int idx = rand() % blocks.size();
+      Block b = blocks[ idx ];
+      for( size_t j = 0; j < b.bytes; j++ )
+        if( b.ptr[ j ] != b.pattern ) {
+          std::cout << "Block at " << (void*)b.ptr << " was overwritten\n";
+          exit( 1 );
+        }
+      slabs->free( b.ptr );
+      blocks[ idx ] = blocks.back();
+      blocks.pop_back();
+    }
+  }
+  for( Block &b : blocks )
+    slabs->free( b.ptr );
+  std::cout << "Churn: " << NUM_OPS << " operations, " << failed << " allocations did not fit.\n";
+}
+
+// Allocates random 1-MAX_SMALL byte objects until the heap is full and returns how many fit. Objects of 8 bytes or
+// less are too small for a boundary-tag block, so without slabs they are counted as failures and skipped.
+template <class Heap>
+int fill( Heap *heap, int &tooSmall )
+{
+  vector<void *> blocks;
+  tooSmall = 0;
+  for( ;; ) {
+    size_t n = rand() % MAX_SMALL + 1;
+    void *ptr = heap->allocate( n );
+    if( ptr == 0 ) {
+      if( n <= 8 && tooSmall++ < 1000 )
+        continue;
+      break;
+    }
+    blocks.push_back( ptr );
+  }
+  for( void *ptr : blocks )
+    heap->free( ptr );
+  return blocks.size();
+}
+
+// Measures one small allocate immediately followed by its free, as microbench.cpp does for BoundaryTag.
+template <class Heap>
+double nsPerPair( Heap *heap )
+{
+  vector<int> sizes( 4096 );
+  for( int &n : sizes )
+    n = rand() % ( MAX_SMALL - 8 ) + 9;
+
+  void *sink = 0;
+  auto before = std::chrono::steady_clock::now();
+  for( int i = 0; i < NUM_PAIRS; i++ ) {
+    void *block = heap->allocate( sizes[ i & 4095 ] );
+    sink = block;
+    heap->free( block );
+  }
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - before;
+  if( sink == 0 ) {
+    std::cout << "allocate failed\n";
+    exit( 1 );
+  }
+  return elapsed.count() / NUM_PAIRS;
+}
+
+int main()
+{
+  srand( 13 );
+  BoundaryTag *memory = new BoundaryTag();
+  SlabHeap *slabs = new SlabHeap( memory );
+
+  churn( slabs );
+
+  int tooSmall;
+  int plain = fill( memory, tooSmall );
+  std::cout << "1-" << MAX_SMALL << " byte objects that fit: " << plain << " without slabs (" << tooSmall
+            << " too small), ";
+  std::cout << fill( slabs, tooSmall ) << " with slabs.\n";
+
+  std::cout << "9-" << MAX_SMALL << " byte allocate/free pair: " << nsPerPair( memory ) << " ns without slabs, "
+            << nsPerPair( slabs ) << " ns with slabs.\n";
+
+  // With everything freed, only the last slab of each of the four size classes is kept.
+  if( slabs->numSlabs() > 4 ) {
+    std::cout << "Empty slabs were not returned to the heap!\n";
+    exit( 2 );
+  }
+  delete slabs;
+  delete memory;
+  return 0;
+}
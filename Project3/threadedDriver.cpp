@@ -0,0 +1,89 @@
+#include "ConcurrentHeap.hpp"
+#include<iostream>
+#include<string.h>
+#include<stdlib.h>
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<chrono>
+#include<random>
+
+using namespace std;
+
+const int OPS_PER_THREAD = 1000000;
+
+// The shared heap behind one global lock, for comparison with the per-thread caches.
+class LockedHeap {
+public:
+  void* allocate( size_t n ) { std::lock_guard<std::mutex> lock( mutex ); return heap.allocate( n ); }
+  void free( void *ptr ) { std::lock_guard<std::mutex> lock( mutex ); heap.free( ptr ); }
+
+private:
+  ArenaHeap heap;
+  std::mutex mutex;
+};
+
+// The driver.cpp workload: allocate 1-150 bytes 55% of the time, otherwise free a random live block. Each thread
+// has its own generator, since rand() is shared between threads.
+template <class Heap>
+void workload( Heap *heap, int seed )
+{
+  std::minstd_rand random( seed );
+  vector<void *> blocks;
+  int allocatePercentage = 55;
+  int maxSize = 150;
+
+  for( int i = 0; i < OPS_PER_THREAD; i++ ) {
+    if( (int)(random() % 100) < allocatePercentage ) {
+      int n = random() % maxSize + 1;
+      void *block = heap->allocate( n );
+      if( block == 0 ) {
+        std::cout << "Out of memory!\n";
+        exit( 1 );
+      }
+      memset( block, 0, n );
+      blocks.push_back( block );
+    } else if( ! blocks.empty() ) {
+      int idx = random() % blocks.size();
+      heap->free( blocks[ idx ] );
+      blocks[ idx ] = blocks.back();
+      blocks.pop_back();
+    }
+  }
+
+  for( void *block : blocks )
+    heap->free( block );
+}
+
+// Runs the workload on numThreads threads sharing one heap and returns the aggregate operations per second.
+template <class Heap>
+double opsPerSecond( int numThreads )
+{
+  Heap *heap = new Heap();
+  vector<std::thread> threads;
+
+  auto before = std::chrono::steady_clock::now();
+  for( int i = 0; i < numThreads; i++ )
+    threads.push_back( std::thread( workload<Heap>, heap, i + 13 ) );
+  for( auto &t : threads )
+    t.join();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - before;
+
+  delete heap;
+  return double( OPS_PER_THREAD ) * numThreads / elapsed.count();
+}
+
+int main( int argc, char *argv[] )
+{
+  int maxThreads = argc > 1 ? atoi( argv[1] ) : std::thread::hardware_concurrency();
+  if( maxThreads < 1 )
+    maxThreads = 1;
+
+  std::cout << "threads   global lock (ops/s)   thread caches (ops/s)\n";
+  for( int numThreads = 1; numThreads <= maxThreads; numThreads++ ) {
+    double locked = opsPerSecond<LockedHeap>( numThreads );
+    double cached = opsPerSecond<ConcurrentHeap>( numThreads );
+    std::cout << numThreads << "\t  " << (long)locked << "\t\t\t" << (long)cached << "\n";
+  }
+  return 0;
+}
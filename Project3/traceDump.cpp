@@ -0,0 +1,86 @@
+#include "HeapTrace.hpp"
+#include<iostream>
+#include<iomanip>
+#include<fstream>
+#include<string.h>
+#include<stdlib.h>
+#include<vector>
+#include<map>
+
+using namespace std;
+
+const char *eventName( uint32_t type )
+{
+  switch( type ) {
+    case HeapTrace::ALLOCATE: return "allocate";
+    case HeapTrace::FREE:     return "free";
+    case HeapTrace::SPLIT:    return "split";
+    case HeapTrace::COALESCE: return "coalesce";
+    case HeapTrace::RESIZE:   return "resize";
+  }
+  return "?";
+}
+
+// Prints a heap.trace file written by HeapTrace::dump as a timeline, one event per line, with the bytes each heap had
+// in use after the event. Heaps are numbered in the order they first appear; threads are numbered by HeapTrace.
+int main( int argc, char *argv[] )
+{
+  const char *path = argc > 1 ? argv[ 1 ] : "heap.trace";
+  ifstream in( path, ios::binary );
+  HeapTrace::FileHeader header;
+  if( ! in.read( (char*)&header, sizeof( header ) ) || memcmp( header.magic, HeapTrace::MAGIC, sizeof( header.magic ) ) != 0 ) {
+    std::cout << path << " is not a heap trace\n";
+    exit( 1 );
+  }
+  vector<HeapTrace::Event> events( header.numEvents );
+  if( ! in.read( (char*)events.data(), events.size() * sizeof( HeapTrace::Event ) ) ) {
+    std::cout << path << " is truncated\n";
+    exit( 1 );
+  }
+  if( events.empty() ) {
+    std::cout << "No events.\n";
+    return 0;
+  }
+
+  map<uint64_t, int> heapNumbers;
+  map<uint64_t, long long> inUse;
+  map<uint32_t, uint64_t> lastSequence;
+  bool lost = false;
+  long long counts[ HeapTrace::RESIZE + 1 ] = {};
+  uint64_t start = events[ 0 ].time;
+
+  std::cout << setw( 10 ) << "seq" << setw( 14 ) << "time" << setw( 6 ) << "heap" << setw( 8 ) << "thread" << "  "
+            << left << setw( 10 ) << "event" << right << setw( 8 ) << "index" << setw( 8 ) << "words" << setw( 8 )
+            << "other" << setw( 12 ) << "in use" << "\n";
+  for( HeapTrace::Event &e : events ) {
+    if( heapNumbers.count( e.heap ) == 0 ) {
+      int number = heapNumbers.size();
+      heapNumbers[ e.heap ] = number;
+    }
+    // Every thread numbers its own events, so a gap in a thread's numbers is an event that was overwritten.
+    if( lastSequence.count( e.thread ) != 0 && e.sequence != lastSequence[ e.thread ] + 1 )
+      lost = true;
+    lastSequence[ e.thread ] = e.sequence;
+    // The trace may start part way through, so in-use bytes are relative to the first event seen.
+    if( e.type == HeapTrace::ALLOCATE )
+      inUse[ e.heap ] += (long long)e.numWords * e.wordBytes;
+    else if( e.type == HeapTrace::FREE )
+      inUse[ e.heap ] -= (long long)e.numWords * e.wordBytes;
+    else if( e.type == HeapTrace::RESIZE )
+      inUse[ e.heap ] += ( (long long)e.numWords - e.other ) * e.wordBytes;
+    if( e.type <= HeapTrace::RESIZE )
+      counts[ e.type ]++;
+
+    std::cout << setw( 10 ) << e.sequence << setw( 14 ) << e.time - start << setw( 6 ) << heapNumbers[ e.heap ]
+              << setw( 8 ) << e.thread << "  " << left << setw( 10 ) << eventName( e.type ) << right << setw( 8 )
+              << e.index << setw( 8 ) << e.numWords << setw( 8 ) << e.other << setw( 12 ) << inUse[ e.heap ] << "\n";
+  }
+
+  std::cout << events.size() << " events from " << heapNumbers.size() << " heaps and " << lastSequence.size()
+            << " threads: ";
+  for( int type = HeapTrace::ALLOCATE; type <= HeapTrace::RESIZE; type++ )
+    std::cout << counts[ type ] << " " << eventName( type ) << ( type < HeapTrace::RESIZE ? ", " : "\n" );
+  if( lost )
+    std::cout << "Some events were lost or overwritten while the trace was written.\n";
+  return 0;
+}